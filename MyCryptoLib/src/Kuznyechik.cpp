@@ -4,165 +4,337 @@
 // appropriate header file "Kuznyechik.hpp"
 
 #include <stdexcept>
-
-#include <vector>
-using std::vector;
-
-#include <map>
-using std::map;
+#include <atomic>
 
 #include <cstring>
+#include <cstdint>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 #include <MyCryptoLib/Kuznyechik.hpp>
 #include <MyCryptoLib/mycrypto.hpp>
+#include <MyCryptoLib/rawbytes.hpp>
+#include <MyCryptoLib/useful.hpp>
+using raw_bytes::xor_inplace;
+using raw_bytes::xor_n;
 
-bool Kuznyechik::is_init = false;
-
-const vector<BYTE> nonlinear_transform_perm = {
-	252, 238, 221, 17, 207, 110, 49, 22, 251, 196,
-	250, 218, 35, 197, 4, 77, 233, 119, 240, 219,
-	147, 46, 153, 186, 23, 54, 241, 187, 20, 205,
-	95, 193, 249, 24, 101, 90, 226, 92, 239, 33,
-	129, 28, 60, 66, 139, 1, 142, 79, 5, 132, 2,
-	174, 227, 106, 143, 160, 6, 11, 237, 152, 127,
-	212, 211, 31, 235, 52, 44, 81, 234, 200, 72,
-	171, 242, 42, 104, 162, 253, 58, 206, 204, 181,
-	112, 14, 86, 8, 12, 118, 18, 191, 114, 19, 71,
-	156, 183, 93, 135, 21, 161, 150, 41, 16, 123,
-	154, 199, 243, 145, 120, 111, 157, 158, 178, 177,
-	50, 117, 25, 61, 255, 53, 138, 126, 109, 84,
-	198, 128, 195, 189, 13, 87, 223, 245, 36, 169,
-	62, 168, 67, 201, 215, 121, 214, 246, 124, 34,
-	185, 3, 224, 15, 236, 222, 122, 148, 176, 188,
-	220, 232, 40, 80, 78, 51, 10, 74, 167, 151, 96,
-	115, 30, 0, 98, 68, 26, 184, 56, 130, 100, 159,
-	38, 65, 173, 69, 70, 146, 39, 94, 85, 47, 140,
-	163, 165, 125, 105, 213, 149, 59, 7, 88, 179,
-	64, 134, 172, 29, 247, 48, 55, 107, 228, 136,
-	217, 231, 137, 225, 27, 131, 73, 76, 63, 248,
-	254, 141, 83, 170, 144, 202, 216, 133, 97, 32,
-	113, 103, 164, 45, 43, 9, 91, 203, 155, 37,
-	208, 190, 229, 108, 82, 89, 166, 116, 210, 230,
-	244, 180, 192, 209, 102, 175, 194, 57, 75, 99,
-	182
-};
-const map<BYTE, BYTE> direct_permutation, inverse_permutation;
+// ======================== Tables Of Constants ============================= //
+#include <MyCryptoLib/KuznyechikData.hpp>
 
-const vector<WORD> linear_transform_coeff = {
+const WORD linear_transform_coeff[BLOCK_LENGTH] = {
 	148, 32, 133, 16, 194, 192, 1, 251, 1, 192,
 	194, 16, 133, 32, 148, 1
 };
-const WORD linear_transform_modulus = 0x1C3;
+constexpr WORD linear_transform_modulus = 0x1C3;
+
+// ===================== Compile-Time Fused Tables ========================== //
+// Entry b of table i is L(S(x)) for block x with byte b at position i
+// and zeros elsewhere. L is linear, so L(S(x)) of any block is the xor
+// of 16 entries, one per byte. Inverse tables hold inverse L of inverse S
+// the same way. All of them are computed by the compiler from the matrices
+// of KuznyechikData.hpp and live in read-only data
+struct alignas(16) LSTable {
+	uint64_t entry[BLOCK_LENGTH][256][2];
+};
+
+constexpr unsigned gf_double(unsigned x) {
+	return ((x << 1) ^ (x & 0x80 ? linear_transform_modulus : 0)) & 0xff;
+}
+constexpr unsigned gf_multiply(unsigned lhs, unsigned rhs) {
+	return rhs ? ((rhs & 1 ? lhs : 0) ^ gf_multiply(gf_double(lhs), rhs >> 1)) : 0;
+}
+
+// Position of k-th byte of a block in the word which holds it
+constexpr unsigned byte_shift(unsigned k) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return 8 * (7 - k);
+#else
+	return 8 * k;
+#endif
+}
+
+// Half of entry x of table i: bytes 8 * half, ..., 8 * half + 7
+constexpr uint64_t table_word(
+	const BYTE (&matrix)[BLOCK_LENGTH][BLOCK_LENGTH],
+	unsigned i, unsigned x, unsigned half, unsigned k = 0)
+{
+	return k == 8 ? 0 :
+		(uint64_t(gf_multiply(x, matrix[8 * half + k][i])) << byte_shift(k)) |
+		table_word(matrix, i, x, half, k + 1);
+}
+
+template <size_t... I>
+constexpr LSTable make_table(
+	const BYTE (&perm)[256],
+	const BYTE (&matrix)[BLOCK_LENGTH][BLOCK_LENGTH],
+	Indices<I...>)
+{
+	return LSTable {{ table_word(matrix, I / 512, perm[I / 2 % 256], I % 2)... }};
+}
 
-const vector<ByteBlock> iteration_constants;
+static constexpr LSTable LS_TABLE = make_table(
+	SUBSTITUTION_PI, LINEAR_MATRIX,
+	MakeIndices<BLOCK_LENGTH * 256 * 2>::type()
+);
+static constexpr LSTable INVERSE_LS_TABLE = make_table(
+	INVERSE_SUBSTITUTION_PI, INVERSE_LINEAR_MATRIX,
+	MakeIndices<BLOCK_LENGTH * 256 * 2>::type()
+);
 
-void init_perms();
-void init_consts();
+// ============================= Functions ================================== //
 void nonlinear_transform_direct128(BYTE * target);
 void nonlinear_transform_inverse128(BYTE * target);
-WORD multiply(WORD lhs, WORD rhs);
-void xor128(BYTE * dst, const BYTE * lhs, const BYTE * rhs);
 BYTE linear_transform_core128(const BYTE * target);
 void linear_transform_direct128(BYTE * target);
 void linear_transform_inverse128(BYTE * target);
 void iteration_linear_transform_direct128(BYTE * target);
 void iteration_linear_transform_inverse128(BYTE * target);
-static void encrypt128(BYTE * target, const vector<ByteBlock> & keys);
-void decrypt128(BYTE * target, const vector<ByteBlock> & keys);
+static void encrypt128(BYTE * target, const BYTE * schedule);
+template <int N> static void encrypt_lookup(BYTE * target, const BYTE * schedule);
+template <int N> static void decrypt_lookup(BYTE * target, const BYTE * schedule);
+static bool simd_supported();
+template <int N> static void encrypt_sse(BYTE * target, const BYTE * schedule);
+template <int N> static void decrypt_sse(BYTE * target, const BYTE * schedule);
+static bool sliced_supported();
+static void encrypt_sliced(BYTE * target, const BYTE * schedule);
+static void decrypt_sliced(BYTE * target, const BYTE * schedule);
+static void key_schedule_sliced(const BYTE * key, BYTE * schedule);
+void decrypt128(BYTE * target, const BYTE * schedule);
+template <void (*LS)(const BYTE *, uint64_t *), void (*InverseLS)(const BYTE *, uint64_t *)>
+static void key_schedule(const BYTE * key, BYTE * schedule);
+static void ls_lookup(const BYTE * x, uint64_t * acc);
+static void inverse_ls_lookup(const BYTE * x, uint64_t * acc);
+static void ls_compact(const BYTE * x, uint64_t * acc);
+static void inverse_ls_compact(const BYTE * x, uint64_t * acc);
+template <int N> static void encrypt_compact(BYTE * target, const BYTE * schedule);
+template <int N> static void decrypt_compact(BYTE * target, const BYTE * schedule);
 void keys_transform128(BYTE * k1, BYTE * k2, int iconst);
 void key_derivation128(BYTE * k1, BYTE * k2, BYTE * k3, BYTE * k4, int ipair);
 
+// Blocks the constant-time engine takes at once
+static const int SLICED_BLOCKS = 16;
+
+// Whole groups are processed in place, the rest is padded to a group
+static void run_sliced(
+	void (*rounds)(BYTE *, const BYTE *),
+	BYTE * target, size_t nblocks, const BYTE * schedule)
+{
+	size_t i = 0;
+	for(; i + SLICED_BLOCKS <= nblocks; i += SLICED_BLOCKS)
+		rounds(target + i * BLOCK_LENGTH, schedule);
+	if(i < nblocks) {
+		BYTE group[SLICED_BLOCKS * BLOCK_LENGTH] = {};
+		size_t length = (nblocks - i) * BLOCK_LENGTH;
+		memcpy(group, target + i * BLOCK_LENGTH, length);
+		rounds(group, schedule);
+		memcpy(target + i * BLOCK_LENGTH, group, length);
+		raw_bytes::secure_zero(group, sizeof group);
+	}
+}
+
 
-Kuznyechik::Kuznyechik(const ByteBlock & key) :
-    keys(10)
+Kuznyechik::Kuznyechik(ByteView key, Engine engine_) :
+    schedule(ByteBlock::cache_aligned(20 * BLOCK_LENGTH)), engine(engine_)
 {
+    if(engine == Engine::simd && !simd_supported())
+        engine = Engine::lookup;
+    if(engine == Engine::constant_time && !sliced_supported())
+        throw std::runtime_error("Kuznyechik: constant_time engine needs SSSE3");
     if(key.size() != 32)
         throw std::invalid_argument("Kuznyechik: The key must be 32 bytes long");
-    if(!is_init) {
-        init_perms();
-        init_consts();
-        is_init = true;
-    }
-    keys[0].reset(key.byte_ptr(), BLOCK_LENGTH);
-    keys[1].reset(key.byte_ptr() + BLOCK_LENGTH, BLOCK_LENGTH);
-    for(int i = 0; i < 4; i++) {
-        keys[2 * i + 2] = ByteBlock(BLOCK_LENGTH);
-        keys[2 * i + 3] = ByteBlock(BLOCK_LENGTH);
-        key_derivation128(
-			keys[2 * i].byte_ptr(),
-			keys[2 * i + 1].byte_ptr(),
-			keys[2 * i + 2].byte_ptr(),
-			keys[2 * i + 3].byte_ptr(),
-			i
-		);
+    rekey(key.byte_ptr());
+}
+
+void Kuznyechik::rekey(const uint8_t * key) {
+    BYTE * round_keys = schedule.byte_ptr();
+    switch(engine) {
+    case Engine::constant_time:
+        // the other derivations index pi by bytes of the key
+        key_schedule_sliced(key, round_keys);
+        break;
+    case Engine::reference:
+        memcpy(round_keys, key, 2 * BLOCK_LENGTH);
+        for(int i = 0; i < 4; i++) {
+            key_derivation128(
+                round_keys + 2 * i * BLOCK_LENGTH,
+                round_keys + (2 * i + 1) * BLOCK_LENGTH,
+                round_keys + (2 * i + 2) * BLOCK_LENGTH,
+                round_keys + (2 * i + 3) * BLOCK_LENGTH,
+                i
+            );
+        }
+        break;
+    case Engine::compact:
+        // keeps off the large tables
+        key_schedule<ls_compact, inverse_ls_compact>(key, round_keys);
+        break;
+    default:
+        key_schedule<ls_lookup, inverse_ls_lookup>(key, round_keys);
     }
 }
-Kuznyechik::Kuznyechik(const Kuznyechik & rhs) {
-	is_init = rhs.is_init;
-	for(auto & iter_key : rhs.keys)
-		keys.push_back(iter_key.deep_copy());
+Kuznyechik::Engine Kuznyechik::best_engine() {
+    static const Engine best = simd_supported() ? Engine::simd : Engine::lookup;
+    return best;
+}
+
+// -1 while no engine is chosen
+static std::atomic<int> chosen_engine(-1);
+
+Kuznyechik::Engine Kuznyechik::default_engine() {
+    int chosen = chosen_engine.load(std::memory_order_relaxed);
+    return chosen < 0 ? best_engine() : static_cast<Engine>(chosen);
+}
+void Kuznyechik::set_default_engine(Engine engine_) {
+    chosen_engine.store(static_cast<int>(engine_), std::memory_order_relaxed);
+}
+
+Kuznyechik::Kuznyechik(const Kuznyechik & rhs) :
+    schedule(rhs.schedule.deep_copy()), engine(rhs.engine)
+{
+    // nothing
 }
 Kuznyechik::~Kuznyechik() {}
 
-void Kuznyechik::encrypt(const ByteBlock & src, ByteBlock & dst) const {
+void Kuznyechik::encrypt_block(const uint8_t * in, uint8_t * out) const noexcept {
+    if(out != in) memcpy(out, in, BLOCK_LENGTH);
+    switch(engine) {
+    case Engine::constant_time:
+        run_sliced(encrypt_sliced, out, 1, schedule.byte_ptr());
+        break;
+    case Engine::simd:
+        encrypt_sse<1>(out, schedule.byte_ptr());
+        break;
+    case Engine::lookup:
+        encrypt_lookup<1>(out, schedule.byte_ptr());
+        break;
+    case Engine::compact:
+        encrypt_compact<1>(out, schedule.byte_ptr());
+        break;
+    default:
+        encrypt128(out, schedule.byte_ptr());
+    }
+}
+void Kuznyechik::decrypt_block(const uint8_t * in, uint8_t * out) const noexcept {
+    if(out != in) memcpy(out, in, BLOCK_LENGTH);
+    switch(engine) {
+    case Engine::constant_time:
+        run_sliced(decrypt_sliced, out, 1, schedule.byte_ptr());
+        break;
+    case Engine::simd:
+        decrypt_sse<1>(out, schedule.byte_ptr());
+        break;
+    case Engine::lookup:
+        decrypt_lookup<1>(out, schedule.byte_ptr());
+        break;
+    case Engine::compact:
+        decrypt_compact<1>(out, schedule.byte_ptr());
+        break;
+    default:
+        decrypt128(out, schedule.byte_ptr());
+    }
+}
+
+void Kuznyechik::encrypt(ByteView src, ByteBlock & dst) const {
     if(src.size() != BLOCK_LENGTH)
         throw std::invalid_argument("Kuznyechik: The block must be 16 bytes length");
-    if(dst != src) dst = src.deep_copy();
-    encrypt128(dst.byte_ptr(), keys);
+    const uint8_t * in = src.byte_ptr();
+    // src may lie in dst, then it moves along with it
+    if(dst.size() != BLOCK_LENGTH) {
+        dst.reset(in, BLOCK_LENGTH);
+        in = dst.byte_ptr();
+    }
+    encrypt_block(in, dst.byte_ptr());
 }
-void Kuznyechik::decrypt(const ByteBlock & src, ByteBlock & dst) const {
+void Kuznyechik::decrypt(ByteView src, ByteBlock & dst) const {
     if(src.size() != BLOCK_LENGTH)
         throw std::invalid_argument("Kuznyechik: The block must be 16 bytes length");
-    if(dst != src) dst = src.deep_copy();
-    decrypt128(dst.byte_ptr(), keys);
-}
-
-void init_perms() {
-	map<BYTE, BYTE> *p_direct, *p_inverse;
-	p_direct = const_cast< map<BYTE, BYTE> * >(&direct_permutation);
-	p_inverse = const_cast< map<BYTE, BYTE> * >(&inverse_permutation);
-	for(int i = 0; i < nonlinear_transform_perm.size(); i++) {
-		(*p_direct)[i] = nonlinear_transform_perm[i];
-		(*p_inverse)[nonlinear_transform_perm[i]] = i;
-	}
+    const uint8_t * in = src.byte_ptr();
+    if(dst.size() != BLOCK_LENGTH) {
+        dst.reset(in, BLOCK_LENGTH);
+        in = dst.byte_ptr();
+    }
+    decrypt_block(in, dst.byte_ptr());
 }
 
-void init_consts() {
-	vector<ByteBlock> * p = const_cast< vector<ByteBlock> * >(&iteration_constants);
-    ByteBlock v128;
-    for(BYTE i = 1; i <= 32; i++) {
-        v128 = ByteBlock(BLOCK_LENGTH, 0);
-		v128[BLOCK_LENGTH - 1] = i;
-        iteration_linear_transform_direct128(v128.byte_ptr());
-		p->push_back(std::move(v128));
-	}
-}
+// Blocks are taken by groups of INTERLEAVE, the rest one by one
+static const int INTERLEAVE = 4;
 
-void xor128(BYTE * dst, const BYTE * lhs, const BYTE * rhs) {
-	const BYTE * p_end = dst + BLOCK_LENGTH;
-	while(dst != p_end) {
-		*(dst++) = *(lhs++) ^ *(rhs++);
-	}
+void Kuznyechik::encrypt_blocks(const uint8_t * src, uint8_t * dst, size_t nblocks) const {
+    if(dst != src) memmove(dst, src, nblocks * BLOCK_LENGTH);
+    const BYTE * round_keys = schedule.byte_ptr();
+    size_t i = 0;
+    switch(engine) {
+    case Engine::constant_time:
+        run_sliced(encrypt_sliced, dst, nblocks, round_keys);
+        break;
+    case Engine::simd:
+        for(; i + INTERLEAVE <= nblocks; i += INTERLEAVE)
+            encrypt_sse<INTERLEAVE>(dst + i * BLOCK_LENGTH, round_keys);
+        for(; i < nblocks; i++)
+            encrypt_sse<1>(dst + i * BLOCK_LENGTH, round_keys);
+        break;
+    case Engine::lookup:
+        for(; i + INTERLEAVE <= nblocks; i += INTERLEAVE)
+            encrypt_lookup<INTERLEAVE>(dst + i * BLOCK_LENGTH, round_keys);
+        for(; i < nblocks; i++)
+            encrypt_lookup<1>(dst + i * BLOCK_LENGTH, round_keys);
+        break;
+    case Engine::compact:
+        for(; i + INTERLEAVE <= nblocks; i += INTERLEAVE)
+            encrypt_compact<INTERLEAVE>(dst + i * BLOCK_LENGTH, round_keys);
+        for(; i < nblocks; i++)
+            encrypt_compact<1>(dst + i * BLOCK_LENGTH, round_keys);
+        break;
+    default:
+        for(; i < nblocks; i++)
+            encrypt128(dst + i * BLOCK_LENGTH, round_keys);
+    }
 }
-WORD multiply(WORD lhs, WORD rhs) {
-	WORD result = 0, modulus = linear_transform_modulus << 7;
-	for(WORD detecter = 0x1; detecter != 0x100; detecter <<= 1, lhs <<= 1)
-		if(rhs & detecter) result ^= lhs;
-	for(WORD detecter = 0x8000; detecter != 0x80; detecter >>= 1, modulus >>= 1)
-		if(result & detecter) result ^= modulus;
-	return result;
+void Kuznyechik::decrypt_blocks(const uint8_t * src, uint8_t * dst, size_t nblocks) const {
+    if(dst != src) memmove(dst, src, nblocks * BLOCK_LENGTH);
+    const BYTE * round_keys = schedule.byte_ptr();
+    size_t i = 0;
+    switch(engine) {
+    case Engine::constant_time:
+        run_sliced(decrypt_sliced, dst, nblocks, round_keys);
+        break;
+    case Engine::simd:
+        for(; i + INTERLEAVE <= nblocks; i += INTERLEAVE)
+            decrypt_sse<INTERLEAVE>(dst + i * BLOCK_LENGTH, round_keys);
+        for(; i < nblocks; i++)
+            decrypt_sse<1>(dst + i * BLOCK_LENGTH, round_keys);
+        break;
+    case Engine::lookup:
+        for(; i + INTERLEAVE <= nblocks; i += INTERLEAVE)
+            decrypt_lookup<INTERLEAVE>(dst + i * BLOCK_LENGTH, round_keys);
+        for(; i < nblocks; i++)
+            decrypt_lookup<1>(dst + i * BLOCK_LENGTH, round_keys);
+        break;
+    case Engine::compact:
+        for(; i + INTERLEAVE <= nblocks; i += INTERLEAVE)
+            decrypt_compact<INTERLEAVE>(dst + i * BLOCK_LENGTH, round_keys);
+        for(; i < nblocks; i++)
+            decrypt_compact<1>(dst + i * BLOCK_LENGTH, round_keys);
+        break;
+    default:
+        for(; i < nblocks; i++)
+            decrypt128(dst + i * BLOCK_LENGTH, round_keys);
+    }
 }
+
 void nonlinear_transform_direct128(BYTE * target) {
 	BYTE * p_end = target + BLOCK_LENGTH;
 	while(target != p_end) {
-		*target = direct_permutation.at(*target);
+		*target = SUBSTITUTION_PI[*target];
 		target++;
 	}
 }
 void nonlinear_transform_inverse128(BYTE * target) {
 	BYTE * p_end = target + BLOCK_LENGTH;
 	while(target != p_end) {
-		*target = inverse_permutation.at(*target);
+		*target = INVERSE_SUBSTITUTION_PI[*target];
 		target++;
 	}
 }
@@ -170,7 +342,8 @@ void nonlinear_transform_inverse128(BYTE * target) {
 BYTE linear_transform_core128(const BYTE * target) {
 	WORD result = 0;
 	for(int i = 0; i < BLOCK_LENGTH; i++) {
-        result ^= multiply(target[i], linear_transform_coeff[i]);
+        result ^= raw_bytes::GaloisField<linear_transform_modulus>::multiply(
+            target[i], linear_transform_coeff[i]);
     }
 	return result;
 }
@@ -198,31 +371,105 @@ void iteration_linear_transform_inverse128(BYTE * target) {
         linear_transform_inverse128(target);
 }
 
-static void encrypt128(BYTE * target, const vector<ByteBlock> & keys) {
-	xor128(target, target, keys[0].byte_ptr());
+static void encrypt128(BYTE * target, const BYTE * schedule) {
+	xor_inplace(target, schedule, BLOCK_LENGTH);
 	for(int i = 1; i < 10; i++) {
 		nonlinear_transform_direct128(target);
 		iteration_linear_transform_direct128(target);
-		xor128(target, target, keys[i].byte_ptr());
+		xor_inplace(target, schedule + i * BLOCK_LENGTH, BLOCK_LENGTH);
+	}
+}
+
+// N consecutive blocks at target go through the rounds side by side,
+// so lookups of one block don't wait for those of another
+template <int N>
+static void encrypt_lookup(BYTE * target, const BYTE * schedule) {
+	const LSTable & tables = LS_TABLE;
+	uint64_t block[N][2], key[2];
+
+	memcpy(block, target, N * BLOCK_LENGTH);
+	memcpy(key, schedule, BLOCK_LENGTH);
+	for(int n = 0; n < N; n++) {
+		block[n][0] ^= key[0];
+		block[n][1] ^= key[1];
+	}
+	for(int i = 1; i < 10; i++) {
+		uint64_t next[N][2];
+		memcpy(key, schedule + i * BLOCK_LENGTH, BLOCK_LENGTH);
+		for(int n = 0; n < N; n++) {
+			next[n][0] = key[0];
+			next[n][1] = key[1];
+		}
+		for(int j = 0; j < BLOCK_LENGTH; j++) {
+			for(int n = 0; n < N; n++) {
+				BYTE b = reinterpret_cast<const BYTE *>(block[n])[j];
+				next[n][0] ^= tables.entry[j][b][0];
+				next[n][1] ^= tables.entry[j][b][1];
+			}
+		}
+		memcpy(block, next, sizeof block);
+	}
+	memcpy(target, block, N * BLOCK_LENGTH);
+}
+
+// Decryption round is X = inverse S(inverse L(X)) ^ K. Carrying
+// Y = inverse L(X) instead of X turns it into Y = T(Y) ^ inverse L(K)
+// where T is the fused inverse table. Only the first inverse L and the last
+// inverse S are left on their own
+template <int N>
+static void decrypt_lookup(BYTE * target, const BYTE * schedule) {
+	const LSTable & tables = INVERSE_LS_TABLE;
+	uint64_t block[N][2], next[N][2], key[2];
+	BYTE * bytes = reinterpret_cast<BYTE *>(block);
+
+	memcpy(block, target, N * BLOCK_LENGTH);
+	xor_inplace(bytes, schedule + 9 * BLOCK_LENGTH, BLOCK_LENGTH);
+	for(int n = 1; n < N; n++)
+		xor_inplace(bytes + n * BLOCK_LENGTH, schedule + 9 * BLOCK_LENGTH, BLOCK_LENGTH);
+	// inverse L alone is the table lookup of S(x)
+	for(int j = 0; j < N * BLOCK_LENGTH; j++)
+		bytes[j] = SUBSTITUTION_PI[bytes[j]];
+
+	for(int i = 9; i > 0; i--) {
+		// the first lookup has no key to add
+		if(i == 9) memset(key, 0, BLOCK_LENGTH);
+		else memcpy(key, schedule + (10 + i) * BLOCK_LENGTH, BLOCK_LENGTH);
+		for(int n = 0; n < N; n++) {
+			next[n][0] = key[0];
+			next[n][1] = key[1];
+		}
+		for(int j = 0; j < BLOCK_LENGTH; j++) {
+			for(int n = 0; n < N; n++) {
+				BYTE b = bytes[n * BLOCK_LENGTH + j];
+				next[n][0] ^= tables.entry[j][b][0];
+				next[n][1] ^= tables.entry[j][b][1];
+			}
+		}
+		memcpy(block, next, sizeof block);
 	}
+
+	for(int j = 0; j < N * BLOCK_LENGTH; j++)
+		bytes[j] = INVERSE_SUBSTITUTION_PI[bytes[j]];
+	for(int n = 0; n < N; n++)
+		xor_n(target + n * BLOCK_LENGTH, bytes + n * BLOCK_LENGTH, schedule, BLOCK_LENGTH);
 }
 
-void decrypt128(BYTE * target, const vector<ByteBlock> & keys) {
-	xor128(target, target, keys[9].byte_ptr());
+void decrypt128(BYTE * target, const BYTE * schedule) {
+	xor_inplace(target, schedule + 9 * BLOCK_LENGTH, BLOCK_LENGTH);
 	for(int i = 8; i >= 0; i--) {
 		iteration_linear_transform_inverse128(target);
         nonlinear_transform_inverse128(target);
-        xor128(target, target, keys[i].byte_ptr());
+        xor_inplace(target, schedule + i * BLOCK_LENGTH, BLOCK_LENGTH);
 	}
 }
 
 void keys_transform128(BYTE * k1, BYTE * k2, int iconst) {
 	BYTE buffer[BLOCK_LENGTH];
 	memcpy(buffer, k1, BLOCK_LENGTH);
-	xor128(k1, k1, iteration_constants[iconst].byte_ptr());
+	xor_inplace(k1, ITERATION_CONSTANTS[iconst], BLOCK_LENGTH);
 	nonlinear_transform_direct128(k1);
 	iteration_linear_transform_direct128(k1);
-	xor128(k1, k2, k1);
+	xor_inplace(k1, k2, BLOCK_LENGTH);
 	memcpy(k2, buffer, BLOCK_LENGTH);
 }
 
@@ -233,3 +480,425 @@ void key_derivation128(BYTE * k1, BYTE * k2, BYTE * k3, BYTE * k4, int ipair) {
 		keys_transform128(k3, k4, ipair * 8 + i);
 	}
 }
+
+// acc ^= L(S(x)) and acc ^= inverse L(inverse S(x)) for one block,
+// the way the lookup engine does it
+static void ls_lookup(const BYTE * x, uint64_t * acc) {
+	for(int j = 0; j < BLOCK_LENGTH; j++) {
+		acc[0] ^= LS_TABLE.entry[j][x[j]][0];
+		acc[1] ^= LS_TABLE.entry[j][x[j]][1];
+	}
+}
+static void inverse_ls_lookup(const BYTE * x, uint64_t * acc) {
+	for(int j = 0; j < BLOCK_LENGTH; j++) {
+		acc[0] ^= INVERSE_LS_TABLE.entry[j][x[j]][0];
+		acc[1] ^= INVERSE_LS_TABLE.entry[j][x[j]][1];
+	}
+}
+
+// Round keys in a row, then inverse L of each. A step of derivation is
+// k1, k2 = L(S(k1 ^ c)) ^ k2, k1 which is a round of a table engine,
+// inverse L alone is the inverse round applied to S of the key
+template <void (*LS)(const BYTE *, uint64_t *), void (*InverseLS)(const BYTE *, uint64_t *)>
+static void key_schedule(const BYTE * key, BYTE * schedule) {
+	uint64_t k1[2], k2[2];
+	BYTE bytes[BLOCK_LENGTH];
+
+	memcpy(schedule, key, 2 * BLOCK_LENGTH);
+	memcpy(k1, key, BLOCK_LENGTH);
+	memcpy(k2, key + BLOCK_LENGTH, BLOCK_LENGTH);
+	for(int i = 0; i < 32; i++) {
+		xor_n(bytes, reinterpret_cast<const BYTE *>(k1), ITERATION_CONSTANTS[i], BLOCK_LENGTH);
+		uint64_t next[2] = { k2[0], k2[1] };
+		LS(bytes, next);
+		memcpy(k2, k1, BLOCK_LENGTH);
+		memcpy(k1, next, BLOCK_LENGTH);
+		if(i % 8 == 7) {
+			memcpy(schedule + (i / 4 + 1) * BLOCK_LENGTH, k1, BLOCK_LENGTH);
+			memcpy(schedule + (i / 4 + 2) * BLOCK_LENGTH, k2, BLOCK_LENGTH);
+		}
+	}
+
+	for(int i = 0; i < 10; i++) {
+		uint64_t inverse[2] = { 0, 0 };
+		for(int j = 0; j < BLOCK_LENGTH; j++)
+			bytes[j] = SUBSTITUTION_PI[schedule[i * BLOCK_LENGTH + j]];
+		InverseLS(bytes, inverse);
+		memcpy(schedule + (10 + i) * BLOCK_LENGTH, inverse, BLOCK_LENGTH);
+	}
+	raw_bytes::secure_zero(reinterpret_cast<BYTE *>(k1), BLOCK_LENGTH);
+	raw_bytes::secure_zero(reinterpret_cast<BYTE *>(k2), BLOCK_LENGTH);
+	raw_bytes::secure_zero(bytes, BLOCK_LENGTH);
+}
+
+// =========================== Compact Engine =============================== //
+// S through its table of 256 bytes, then L as the xor of 32 entries, one
+// per nibble: L is linear over bits, so the nibbles of a byte may go
+// through it apart. 8 KB of tables per direction instead of 64 KB,
+// for twice as many lookups a round
+struct alignas(16) NibbleTable {
+	uint64_t entry[BLOCK_LENGTH][2][16][2];
+};
+
+// entry[i][h][n] is L of the block with byte i = n << 4 * h, zeros elsewhere
+template <size_t... I>
+constexpr NibbleTable make_nibble_table(
+	const BYTE (&matrix)[BLOCK_LENGTH][BLOCK_LENGTH],
+	Indices<I...>)
+{
+	return NibbleTable {{ table_word(matrix, I / 64, (I / 2 % 16) << (I / 32 % 2 * 4), I % 2)... }};
+}
+
+static constexpr NibbleTable L_NIBBLES = make_nibble_table(
+	LINEAR_MATRIX, MakeIndices<BLOCK_LENGTH * 2 * 16 * 2>::type()
+);
+static constexpr NibbleTable INVERSE_L_NIBBLES = make_nibble_table(
+	INVERSE_LINEAR_MATRIX, MakeIndices<BLOCK_LENGTH * 2 * 16 * 2>::type()
+);
+
+// block[n] = key ^ L(perm(block[n])) for N blocks side by side
+template <int N>
+static inline void round_compact(
+	const BYTE (&perm)[256], const NibbleTable & table,
+	uint64_t (*block)[2], const uint64_t * key)
+{
+#if defined(__x86_64__)
+	// SSE2 is there on every x86-64, an entry is one load
+	const __m128i * entries = reinterpret_cast<const __m128i *>(table.entry);
+	__m128i next[N];
+	for(int n = 0; n < N; n++)
+		next[n] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(key));
+	for(int j = 0; j < BLOCK_LENGTH; j++) {
+		for(int n = 0; n < N; n++) {
+			BYTE b = perm[reinterpret_cast<const BYTE *>(block[n])[j]];
+			next[n] = _mm_xor_si128(next[n], _mm_load_si128(entries + 32 * j + (b & 0xf)));
+			next[n] = _mm_xor_si128(next[n], _mm_load_si128(entries + 32 * j + 16 + (b >> 4)));
+		}
+	}
+	memcpy(block, next, sizeof next);
+#else
+	uint64_t next[N][2];
+	for(int n = 0; n < N; n++) {
+		next[n][0] = key[0];
+		next[n][1] = key[1];
+	}
+	for(int j = 0; j < BLOCK_LENGTH; j++) {
+		for(int n = 0; n < N; n++) {
+			BYTE b = perm[reinterpret_cast<const BYTE *>(block[n])[j]];
+			const uint64_t * lo = table.entry[j][0][b & 0xf];
+			const uint64_t * hi = table.entry[j][1][b >> 4];
+			next[n][0] ^= lo[0] ^ hi[0];
+			next[n][1] ^= lo[1] ^ hi[1];
+		}
+	}
+	memcpy(block, next, sizeof next);
+#endif
+}
+
+template <int N>
+static void encrypt_compact(BYTE * target, const BYTE * schedule) {
+	uint64_t block[N][2], key[2];
+
+	memcpy(block, target, N * BLOCK_LENGTH);
+	memcpy(key, schedule, BLOCK_LENGTH);
+	for(int n = 0; n < N; n++) {
+		block[n][0] ^= key[0];
+		block[n][1] ^= key[1];
+	}
+	for(int i = 1; i < 10; i++) {
+		memcpy(key, schedule + i * BLOCK_LENGTH, BLOCK_LENGTH);
+		round_compact<N>(SUBSTITUTION_PI, L_NIBBLES, block, key);
+	}
+	memcpy(target, block, N * BLOCK_LENGTH);
+}
+
+// Carries inverse L of the state like the lookup engine does
+template <int N>
+static void decrypt_compact(BYTE * target, const BYTE * schedule) {
+	uint64_t block[N][2], key[2] = { 0, 0 };
+	BYTE * bytes = reinterpret_cast<BYTE *>(block);
+
+	memcpy(block, target, N * BLOCK_LENGTH);
+	for(int n = 0; n < N; n++)
+		xor_inplace(bytes + n * BLOCK_LENGTH, schedule + 9 * BLOCK_LENGTH, BLOCK_LENGTH);
+	// inverse S of the round undoes this S, which leaves inverse L alone
+	for(int j = 0; j < N * BLOCK_LENGTH; j++)
+		bytes[j] = SUBSTITUTION_PI[bytes[j]];
+
+	for(int i = 9; i > 0; i--) {
+		if(i != 9) memcpy(key, schedule + (10 + i) * BLOCK_LENGTH, BLOCK_LENGTH);
+		round_compact<N>(INVERSE_SUBSTITUTION_PI, INVERSE_L_NIBBLES, block, key);
+	}
+
+	for(int j = 0; j < N * BLOCK_LENGTH; j++)
+		bytes[j] = INVERSE_SUBSTITUTION_PI[bytes[j]];
+	for(int n = 0; n < N; n++)
+		xor_n(target + n * BLOCK_LENGTH, bytes + n * BLOCK_LENGTH, schedule, BLOCK_LENGTH);
+}
+
+static void ls_compact(const BYTE * x, uint64_t * acc) {
+	uint64_t block[1][2];
+	memcpy(block, x, BLOCK_LENGTH);
+	round_compact<1>(SUBSTITUTION_PI, L_NIBBLES, block, acc);
+	memcpy(acc, block, BLOCK_LENGTH);
+}
+static void inverse_ls_compact(const BYTE * x, uint64_t * acc) {
+	uint64_t block[1][2];
+	memcpy(block, x, BLOCK_LENGTH);
+	round_compact<1>(INVERSE_SUBSTITUTION_PI, INVERSE_L_NIBBLES, block, acc);
+	memcpy(acc, block, BLOCK_LENGTH);
+}
+
+// ============================ SIMD Engine ================================= //
+#if defined(__x86_64__)
+
+static inline __m128i load_key(const BYTE * schedule, int i) {
+	return _mm_load_si128(reinterpret_cast<const __m128i *>(schedule) + i);
+}
+
+// block[n] = key ^ xor of 16 table entries picked by bytes of block[n]
+// for N blocks side by side. Bytes are read back from memory, which is
+// cheaper than extracting them from the registers one by one
+template <int N>
+static inline void ls_sse(const LSTable & table, __m128i * block, __m128i key) {
+	const __m128i * entries = reinterpret_cast<const __m128i *>(table.entry);
+	alignas(16) BYTE bytes[N][BLOCK_LENGTH];
+	__m128i acc_lo[N], acc_hi[N];
+	for(int n = 0; n < N; n++) {
+		_mm_store_si128(reinterpret_cast<__m128i *>(bytes[n]), block[n]);
+		acc_lo[n] = key;
+		acc_hi[n] = _mm_setzero_si128();
+	}
+	for(int j = 0; j < 8; j++) {
+		for(int n = 0; n < N; n++) {
+			acc_lo[n] = _mm_xor_si128(acc_lo[n],
+				_mm_load_si128(entries + j * 256 + bytes[n][j]));
+			acc_hi[n] = _mm_xor_si128(acc_hi[n],
+				_mm_load_si128(entries + (j + 8) * 256 + bytes[n][j + 8]));
+		}
+	}
+	for(int n = 0; n < N; n++)
+		block[n] = _mm_xor_si128(acc_lo[n], acc_hi[n]);
+}
+
+template <int N>
+static void encrypt_sse(BYTE * target, const BYTE * schedule) {
+	__m128i block[N];
+	for(int n = 0; n < N; n++) {
+		block[n] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(target) + n);
+		block[n] = _mm_xor_si128(block[n], load_key(schedule, 0));
+	}
+	for(int i = 1; i < 10; i++)
+		ls_sse<N>(LS_TABLE, block, load_key(schedule, i));
+	for(int n = 0; n < N; n++)
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(target) + n, block[n]);
+}
+
+template <int N>
+static void decrypt_sse(BYTE * target, const BYTE * schedule) {
+	alignas(16) BYTE bytes[N * BLOCK_LENGTH];
+	__m128i block[N];
+	for(int n = 0; n < N; n++) {
+		block[n] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(target) + n);
+		block[n] = _mm_xor_si128(block[n], load_key(schedule, 9));
+		_mm_store_si128(reinterpret_cast<__m128i *>(bytes) + n, block[n]);
+	}
+	for(int j = 0; j < N * BLOCK_LENGTH; j++)
+		bytes[j] = SUBSTITUTION_PI[bytes[j]];
+	for(int n = 0; n < N; n++)
+		block[n] = _mm_load_si128(reinterpret_cast<const __m128i *>(bytes) + n);
+
+	ls_sse<N>(INVERSE_LS_TABLE, block, _mm_setzero_si128());
+	for(int i = 8; i > 0; i--)
+		ls_sse<N>(INVERSE_LS_TABLE, block, load_key(schedule, 10 + i));
+
+	for(int n = 0; n < N; n++)
+		_mm_store_si128(reinterpret_cast<__m128i *>(bytes) + n, block[n]);
+	for(int j = 0; j < N * BLOCK_LENGTH; j++)
+		bytes[j] = INVERSE_SUBSTITUTION_PI[bytes[j]];
+	for(int n = 0; n < N; n++) {
+		block[n] = _mm_load_si128(reinterpret_cast<const __m128i *>(bytes) + n);
+		block[n] = _mm_xor_si128(block[n], load_key(schedule, 0));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(target) + n, block[n]);
+	}
+}
+
+// Nothing above SSE2, which every x86-64 has
+static bool simd_supported() {
+	return true;
+}
+
+// ======================== Constant-Time Engine ============================ //
+// 16 blocks are sliced by bytes: state[j] holds byte j of every block.
+// S is looked up in registers: each row of 16 entries of pi is shuffled
+// by the low nibbles and kept only where the high nibble matches.
+// L multiplies state by its matrix, products of a constant and a byte
+// are two shuffles of 16 precomputed products with the nibbles. Addresses
+// of every load depend on loop counters only, never on the data or keys
+
+// entry[i][j][h][n] is matrix[i][j] * (n << 4 * h)
+struct alignas(16) NibbleProducts {
+	BYTE entry[BLOCK_LENGTH][BLOCK_LENGTH][2][16];
+};
+
+template <size_t... I>
+constexpr NibbleProducts make_products(
+	const BYTE (&matrix)[BLOCK_LENGTH][BLOCK_LENGTH],
+	Indices<I...>)
+{
+	return NibbleProducts {{
+		BYTE(gf_multiply(matrix[I / 512][I / 32 % 16], (I % 16) << (I / 16 % 2 * 4)))...
+	}};
+}
+
+static constexpr NibbleProducts L_PRODUCTS = make_products(
+	LINEAR_MATRIX, MakeIndices<BLOCK_LENGTH * BLOCK_LENGTH * 32>::type()
+);
+static constexpr NibbleProducts INVERSE_L_PRODUCTS = make_products(
+	INVERSE_LINEAR_MATRIX, MakeIndices<BLOCK_LENGTH * BLOCK_LENGTH * 32>::type()
+);
+
+__attribute__((target("ssse3")))
+static inline __m128i load(const BYTE * p) {
+	return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+// Swap rows and columns of 16 x 16 bytes. Every pass sends the byte
+// at row r, column c to row 2 * (r % 8) + c / 8, column 2 * (c % 8) + r / 8,
+// that is rotates the 8 bits of its index by one, four passes swap halves
+__attribute__((target("ssse3")))
+static void transpose(__m128i * rows) {
+	for(int pass = 0; pass < 4; pass++) {
+		__m128i next[BLOCK_LENGTH];
+		for(int i = 0; i < 8; i++) {
+			next[2 * i] = _mm_unpacklo_epi8(rows[i], rows[i + 8]);
+			next[2 * i + 1] = _mm_unpackhi_epi8(rows[i], rows[i + 8]);
+		}
+		memcpy(rows, next, sizeof next);
+	}
+}
+
+__attribute__((target("ssse3")))
+static void add_key_sliced(__m128i * state, const BYTE * key) {
+	__m128i k = load(key);
+	for(int j = 0; j < BLOCK_LENGTH; j++)
+		state[j] = _mm_xor_si128(state[j], _mm_shuffle_epi8(k, _mm_set1_epi8(j)));
+}
+
+__attribute__((target("ssse3")))
+static void substitute_sliced(const BYTE (&perm)[256], __m128i * state) {
+	// x ^ (k << 4) is below 16 only when the high nibble of x is k,
+	// adding 0x70 with saturation sets the bit which makes shuffle give 0
+	// for all the others
+	const __m128i bias = _mm_set1_epi8(0x70);
+	for(int j = 0; j < BLOCK_LENGTH; j++) {
+		__m128i result = _mm_setzero_si128();
+		for(int k = 0; k < 16; k++) {
+			__m128i index = _mm_adds_epu8(_mm_xor_si128(state[j], _mm_set1_epi8(k << 4)), bias);
+			result = _mm_or_si128(result, _mm_shuffle_epi8(load(perm + 16 * k), index));
+		}
+		state[j] = result;
+	}
+}
+
+__attribute__((target("ssse3")))
+static void linear_sliced(const NibbleProducts & products, __m128i * state) {
+	const __m128i low = _mm_set1_epi8(0x0f);
+	__m128i nibbles[BLOCK_LENGTH][2];
+	for(int j = 0; j < BLOCK_LENGTH; j++) {
+		nibbles[j][0] = _mm_and_si128(state[j], low);
+		nibbles[j][1] = _mm_and_si128(_mm_srli_epi16(state[j], 4), low);
+	}
+	for(int i = 0; i < BLOCK_LENGTH; i++) {
+		__m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+		for(int j = 0; j < BLOCK_LENGTH; j++) {
+			lo = _mm_xor_si128(lo, _mm_shuffle_epi8(load(products.entry[i][j][0]), nibbles[j][0]));
+			hi = _mm_xor_si128(hi, _mm_shuffle_epi8(load(products.entry[i][j][1]), nibbles[j][1]));
+		}
+		state[i] = _mm_xor_si128(lo, hi);
+	}
+}
+
+// SLICED_BLOCKS blocks at target, round keys lie in a row in schedule
+__attribute__((target("ssse3")))
+static void encrypt_sliced(BYTE * target, const BYTE * schedule) {
+	__m128i state[BLOCK_LENGTH];
+	memcpy(state, target, sizeof state);
+	transpose(state);
+	add_key_sliced(state, schedule);
+	for(int i = 1; i < 10; i++) {
+		substitute_sliced(SUBSTITUTION_PI, state);
+		linear_sliced(L_PRODUCTS, state);
+		add_key_sliced(state, schedule + i * BLOCK_LENGTH);
+	}
+	transpose(state);
+	memcpy(target, state, sizeof state);
+}
+
+__attribute__((target("ssse3")))
+static void decrypt_sliced(BYTE * target, const BYTE * schedule) {
+	__m128i state[BLOCK_LENGTH];
+	memcpy(state, target, sizeof state);
+	transpose(state);
+	add_key_sliced(state, schedule + 9 * BLOCK_LENGTH);
+	for(int i = 8; i >= 0; i--) {
+		linear_sliced(INVERSE_L_PRODUCTS, state);
+		substitute_sliced(INVERSE_SUBSTITUTION_PI, state);
+		add_key_sliced(state, schedule + i * BLOCK_LENGTH);
+	}
+	transpose(state);
+	memcpy(target, state, sizeof state);
+}
+
+// The same rounds derive the keys, one block copied to every slice
+__attribute__((target("ssse3")))
+static void key_schedule_sliced(const BYTE * key, BYTE * schedule) {
+	memcpy(schedule, key, 2 * BLOCK_LENGTH);
+	for(int pair = 0; pair < 4; pair++) {
+		BYTE * k1 = schedule + (2 * pair + 2) * BLOCK_LENGTH;
+		BYTE * k2 = k1 + BLOCK_LENGTH;
+		memcpy(k1, k1 - 2 * BLOCK_LENGTH, 2 * BLOCK_LENGTH);
+		for(int i = 0; i < 8; i++) {
+			__m128i state[BLOCK_LENGTH];
+			BYTE next[BLOCK_LENGTH];
+			for(int j = 0; j < BLOCK_LENGTH; j++)
+				state[j] = _mm_set1_epi8(k1[j] ^ ITERATION_CONSTANTS[8 * pair + i][j]);
+			substitute_sliced(SUBSTITUTION_PI, state);
+			linear_sliced(L_PRODUCTS, state);
+			for(int j = 0; j < BLOCK_LENGTH; j++)
+				next[j] = _mm_cvtsi128_si32(state[j]) ^ k2[j];
+			memcpy(k2, k1, BLOCK_LENGTH);
+			memcpy(k1, next, BLOCK_LENGTH);
+			raw_bytes::secure_zero(next, BLOCK_LENGTH);
+		}
+	}
+}
+
+static bool sliced_supported() {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("ssse3");
+}
+
+#else
+
+static bool simd_supported() {
+	return false;
+}
+template <int N>
+static void encrypt_sse(BYTE * target, const BYTE * schedule) {
+	encrypt_lookup<N>(target, schedule);
+}
+template <int N>
+static void decrypt_sse(BYTE * target, const BYTE * schedule) {
+	decrypt_lookup<N>(target, schedule);
+}
+
+// Only the lookup engines may stand in for simd, constant_time has none
+static bool sliced_supported() {
+	return false;
+}
+static void encrypt_sliced(BYTE *, const BYTE *) {}
+static void decrypt_sliced(BYTE *, const BYTE *) {}
+static void key_schedule_sliced(const BYTE *, BYTE *) {}
+
+#endif
@@ -1,15 +1,19 @@
-#include <vector>
-using std::vector;
-
 #include <stdexcept>
+#include <algorithm>
+#include <thread>
 #include <cstring>
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 #include <MyCryptoLib/rawbytes.hpp>
+#include <MyCryptoLib/useful.hpp>
 using namespace raw_bytes;
 
 #include <MyCryptoLib/Rijndael.hpp>
 
-static const word RIJNDAEL_MODULUS = 0x11B;
+constexpr word RIJNDAEL_MODULUS = 0x11B;
 
 template <unsigned short Nb>
 class RijndaelState {
@@ -53,132 +57,882 @@ template <uint Nb>
 static void inv_sub_bytes(byte * target);
 
 template <uint Nk, uint Nb, uint Nr>
-static void key_expansion(const byte * key, vector<ByteBlock> & round_keys);
+static void key_expansion(const byte * key, byte * w);
 
-static byte affine_transform(byte b);
-static byte inv_affine_transform(byte b);
+// ------------------------ Compile-Time Tables -------------------------
+static constexpr unsigned gf_double(unsigned x) {
+    return ((x << 1) ^ (x & 0x80 ? RIJNDAEL_MODULUS : 0)) & 0xff;
+}
+static constexpr unsigned gf_multiply(unsigned lhs, unsigned rhs) {
+    return rhs ? ((rhs & 1 ? lhs : 0) ^ gf_multiply(gf_double(lhs), rhs >> 1)) : 0;
+}
+static constexpr unsigned gf_power(unsigned base, unsigned p) {
+    return p ? gf_multiply(p & 1 ? base : 1, gf_power(gf_multiply(base, base), p >> 1)) : 1;
+}
+// x^254 is the inverse of x, zero is left zero
+static constexpr unsigned gf_inverse(unsigned x) {
+    return gf_power(x, 254);
+}
 
+static constexpr unsigned rotl8(unsigned b, unsigned n) {
+    return ((b << n) | (b >> (8 - n))) & 0xff;
+}
+static constexpr unsigned affine_transform(unsigned b) {
+    return b ^ rotl8(b, 1) ^ rotl8(b, 2) ^ rotl8(b, 3) ^ rotl8(b, 4) ^ 0x63;
+}
+static constexpr unsigned inv_affine_transform(unsigned b) {
+    return rotl8(b, 1) ^ rotl8(b, 3) ^ rotl8(b, 6) ^ 0x05;
+}
 
-// -------------------- initialization ---------------------------
+static constexpr unsigned sbox_entry(unsigned x) {
+    return affine_transform(gf_inverse(x));
+}
+static constexpr unsigned invsbox_entry(unsigned x) {
+    return gf_inverse(inv_affine_transform(x));
+}
 
-template <uint Nr>
-dword RConstContainer<Nr>::rconst[Nr];
+// Columns of row 0, the other rows are rotations of them
+static constexpr dword te_column(unsigned s) {
+    return dword(gf_multiply(s, 2)) << 24 | dword(s) << 16 | dword(s) << 8 | gf_multiply(s, 3);
+}
+static constexpr dword td_column(unsigned is) {
+    return dword(gf_multiply(is, 0xe)) << 24 | dword(gf_multiply(is, 0x9)) << 16 |
+           dword(gf_multiply(is, 0xd)) << 8 | gf_multiply(is, 0xb);
+}
+static constexpr dword rotr(dword column, unsigned row) {
+    return row ? column >> (8 * row) | column << (32 - 8 * row) : column;
+}
 
-template <uint Nr>
-bool RConstContainer<Nr>::is_init = false;
+// Round constants of every Nk, Nb and Nr Rijndael allows
+static const int RCONST_COUNT = 30;
+
+// S, inverse S and round constants of Rijndael. For AES there are
+// T-tables too: te[r][x] is the column MixColumns makes of S(x) standing
+// at row r, td[r][x] the one InvMixColumns makes of inverse S(x). Columns
+// are 32-bit words with row 0 in the highest byte. The compiler makes
+// them all, so they live in read-only data and need no initialization
+struct RijndaelTables {
+    dword te[DWORD][256];
+    dword td[DWORD][256];
+    byte sbox[256];
+    byte invsbox[256];
+    byte rconst[RCONST_COUNT];
+};
+
+template <size_t... I, size_t... J, size_t... K>
+static constexpr RijndaelTables make_tables(Indices<I...>, Indices<J...>, Indices<K...>) {
+    return RijndaelTables {
+        { rotr(te_column(sbox_entry(I % 256)), I / 256)... },
+        { rotr(td_column(invsbox_entry(I % 256)), I / 256)... },
+        { byte(sbox_entry(J))... },
+        { byte(invsbox_entry(J))... },
+        { byte(gf_power(0x02, K))... }
+    };
+}
+
+static constexpr RijndaelTables TABLES = make_tables(
+    MakeIndices<DWORD * 256>::type(),
+    MakeIndices<256>::type(),
+    MakeIndices<RCONST_COUNT>::type()
+);
+
+// ------------------------------ Rounds ---------------------------------
+// How Rijndael with blocks of Nb dwords and Nr rounds keeps its round keys
+// and runs the rounds over count blocks lying in a row.
+// The generic one goes byte by byte with bytes of round keys in a row
+template <uint Nb, uint Nr>
+struct RijndaelRounds {
+    static size_t schedule_size(AesEngine) {
+        return (Nr + 1) * Nb * DWORD;
+    }
+
+    // Engines are of AES only, others have got the one way
+    template <uint Nk>
+    static void prepare(const byte * key, byte * schedule, AesEngine) {
+        key_expansion<Nk, Nb, Nr>(key, schedule);
+    }
+    // the inverse cipher takes the same keys
+    static void prepare_inverse(byte *, AesEngine) {}
+    static void encrypt(byte * blocks, size_t count, const byte * schedule, AesEngine);
+    static void decrypt(byte * blocks, size_t count, const byte * schedule, AesEngine);
+};
+
+template <uint Nb, uint Nr>
+void RijndaelRounds<Nb, Nr>::encrypt(byte * blocks, size_t count, const byte * schedule, AesEngine) {
+    const size_t length = Nb * DWORD;
+    byte * end = blocks + count * length;
+
+    for(byte * target = blocks; target != end; target += length)
+        add_round_key<Nb>(target, schedule);
+    for(int i = 1; i < Nr; i++) {
+        const byte * key = schedule + i * length;
+        for(byte * target = blocks; target != end; target += length) {
+            sub_bytes<Nb>(target);
+            shift_rows<Nb>(target);
+            mix_columns<Nb>(target);
+            add_round_key<Nb>(target, key);
+        }
+    }
+    for(byte * target = blocks; target != end; target += length) {
+        sub_bytes<Nb>(target);
+        shift_rows<Nb>(target);
+        add_round_key<Nb>(target, schedule + Nr * length);
+    }
+}
+
+template <uint Nb, uint Nr>
+void RijndaelRounds<Nb, Nr>::decrypt(byte * blocks, size_t count, const byte * schedule, AesEngine) {
+    const size_t length = Nb * DWORD;
+    byte * end = blocks + count * length;
+
+	for(byte * target = blocks; target != end; target += length)
+		add_round_key<Nb>(target, schedule + Nr * length);
+	for(int i = Nr - 1; i > 0; i--) {
+		const byte * key = schedule + i * length;
+		for(byte * target = blocks; target != end; target += length) {
+			inv_shift_rows<Nb>(target);
+			inv_sub_bytes<Nb>(target);
+			add_round_key<Nb>(target, key);
+			inv_mix_columns<Nb>(target);
+		}
+	}
+	for(byte * target = blocks; target != end; target += length) {
+		inv_shift_rows<Nb>(target);
+		inv_sub_bytes<Nb>(target);
+		add_round_key<Nb>(target, schedule);
+	}
+}
+
+static inline dword load_column(const byte * p) {
+    return dword(p[0]) << 24 | dword(p[1]) << 16 | dword(p[2]) << 8 | p[3];
+}
+static inline void store_column(byte * p, dword column) {
+    p[0] = column >> 24;
+    p[1] = column >> 16;
+    p[2] = column >> 8;
+    p[3] = column;
+}
+
+// FIPS 197 key expansion a word at a time for any Nk, engines give their
+// own SubWord. Words take bytes little end first, so RotWord
+// is a right rotation
+template <uint Nk, uint Nr, dword SubWord(dword)>
+static void expand_key_words(const byte * key, dword * w) {
+	const int n_words = 4 * (Nr + 1);
+	dword rconst = 0x01;
+
+	for(uint i = 0; i < Nk; i++)
+		w[i] = key[DWORD * i] | key[DWORD * i + 1] << 8 |
+			key[DWORD * i + 2] << 16 | dword(key[DWORD * i + 3]) << 24;
+	for(int i = Nk; i < n_words; i++) {
+		dword tmp = w[i - 1];
+		if(i % Nk == 0) {
+			tmp = SubWord(tmp);
+			tmp = (tmp >> 8 | tmp << 24) ^ rconst;
+			rconst = (rconst << 1) ^ (rconst & 0x80 ? RIJNDAEL_MODULUS : 0);
+		} else if(Nk > 6 && i % Nk == 4) {
+			tmp = SubWord(tmp);
+		}
+		w[i] = w[i - Nk] ^ tmp;
+	}
+}
+
+// ------------------------------- AES-NI --------------------------------
+#if defined(__x86_64__)
 
+static bool aesni_supported() {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("aes");
+}
+
+// SubWord of the second dword is the first one of what
+// AESKEYGENASSIST gives with no round constant
+__attribute__((target("aes")))
+static inline dword sub_word_aesni(dword w) {
+	return _mm_cvtsi128_si32(_mm_aeskeygenassist_si128(_mm_set_epi32(0, 0, w, 0), 0));
+}
+
+template <uint Nk, uint Nr>
+static void prepare_aesni(const byte * key, byte * schedule) {
+	dword w[4 * (Nr + 1)];
+	expand_key_words<Nk, Nr, sub_word_aesni>(key, w);
+	// words hold bytes as they lie in memory on x86
+	memcpy(schedule, w, sizeof w);
+	secure_zero(reinterpret_cast<byte *>(w), sizeof w);
+}
+
+// Round keys of the equivalent inverse cipher made by AESIMC
 template <uint Nr>
-void RConstContainer<Nr>::init() {
-    for(int i = 0 ; i < Nr; i++)
-        rconst[i] = power_field(0x02, i, RIJNDAEL_MODULUS);
+__attribute__((target("aes")))
+static void prepare_inverse_aesni(byte * schedule) {
+	__m128i * keys = reinterpret_cast<__m128i *>(schedule);
+	keys[Nr + 1] = keys[Nr];
+	for(uint round = 1; round < Nr; round++)
+		keys[Nr + 1 + round] = _mm_aesimc_si128(keys[Nr - round]);
+	keys[2 * Nr + 1] = keys[0];
+}
+
+template <int N, uint Nr>
+__attribute__((target("aes")))
+static void encrypt_aesni(byte * blocks, const __m128i * keys) {
+	__m128i state[N];
+	for(int n = 0; n < N; n++)
+		state[n] = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(blocks) + n), keys[0]);
+	for(uint round = 1; round < Nr; round++)
+		for(int n = 0; n < N; n++)
+			state[n] = _mm_aesenc_si128(state[n], keys[round]);
+	for(int n = 0; n < N; n++)
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(blocks) + n, _mm_aesenclast_si128(state[n], keys[Nr]));
+}
+
+template <int N, uint Nr>
+__attribute__((target("aes")))
+static void decrypt_aesni(byte * blocks, const __m128i * keys) {
+	__m128i state[N];
+	for(int n = 0; n < N; n++)
+		state[n] = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(blocks) + n), keys[0]);
+	for(uint round = 1; round < Nr; round++)
+		for(int n = 0; n < N; n++)
+			state[n] = _mm_aesdec_si128(state[n], keys[round]);
+	for(int n = 0; n < N; n++)
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(blocks) + n, _mm_aesdeclast_si128(state[n], keys[Nr]));
 }
 
-bool SBoxContainer::is_init = false;
-byte SBoxContainer::sbox[256];
-byte SBoxContainer::invsbox[256];
+// Blocks AES-NI keeps in flight: AESENC takes several cycles
+// to give its result but starts a new one every cycle
+static const int AESNI_INTERLEAVE = 8;
 
-void SBoxContainer::init() {
-    for(uint i = 0; i < sizeof(sbox); i++) {
-        sbox[i] = affine_transform(inverse_poly(i, RIJNDAEL_MODULUS));
-		invsbox[i] = inverse_poly(inv_affine_transform(i), RIJNDAEL_MODULUS);
+template <uint Nr, bool Decrypt>
+static void run_aesni(byte * blocks, size_t count, const byte * schedule) {
+	const __m128i * keys = reinterpret_cast<const __m128i *>(schedule) + (Decrypt ? Nr + 1 : 0);
+	size_t i = 0;
+	for(; i + AESNI_INTERLEAVE <= count; i += AESNI_INTERLEAVE) {
+		if(Decrypt) decrypt_aesni<AESNI_INTERLEAVE, Nr>(blocks + 16 * i, keys);
+		else encrypt_aesni<AESNI_INTERLEAVE, Nr>(blocks + 16 * i, keys);
+	}
+	for(; i < count; i++) {
+		if(Decrypt) decrypt_aesni<1, Nr>(blocks + 16 * i, keys);
+		else encrypt_aesni<1, Nr>(blocks + 16 * i, keys);
 	}
 }
 
-static byte affine_transform(byte b) {
-    const byte affine_matrix[] = {
-        0xf1, 0xe3, 0xc7, 0x8f, 0x1f, 0x3e, 0x7c, 0xf8
-    };
-    byte affine_shift = 0x63;
+#else
 
-    byte result = 0;
+static bool aesni_supported() {
+	return false;
+}
+template <uint Nk, uint Nr>
+static void prepare_aesni(const byte *, byte *) {}
+template <uint Nr>
+static void prepare_inverse_aesni(byte *) {}
+template <uint Nr, bool Decrypt>
+static void run_aesni(byte *, size_t, const byte *) {}
+
+#endif
+
+// ----------------------------- Bitsliced -------------------------------
+// Kasper and Schwabe keep bit i of every byte of 8 blocks in plane i
+// and run S as a circuit of logic operations over the planes
+// (Boyar and Peralta's one), no table is ever looked up.
+// Planes are two 64-bit lanes of four blocks each, laid out as in
+// BearSSL's ct64: 16 bits for each row of the state, 4 bits for each
+// of its columns, a bit for each block. ShiftRows moves nibbles within
+// rows and MixColumns rotates whole rows. GCC vector extensions
+// make it SSE2 on x86 and plain 64-bit words elsewhere
+typedef uint64_t Planes __attribute__((vector_size(16)));
+
+static const int SLICED_BLOCKS = 8;
+
+template <typename W>
+static inline void sbox_sliced(W * q) {
+    // top linear transformation
+    W x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4], x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+    W y14 = x3 ^ x5, y13 = x0 ^ x6, y9 = x0 ^ x3, y8 = x0 ^ x5, t0 = x1 ^ x2;
+    W y1 = t0 ^ x7, y4 = y1 ^ x3, y12 = y13 ^ y14, y2 = y1 ^ x0, y5 = y1 ^ x6;
+    W y3 = y5 ^ y8, t1 = x4 ^ y12, y15 = t1 ^ x5, y20 = t1 ^ x1, y6 = y15 ^ x7;
+    W y10 = y15 ^ t0, y11 = y20 ^ y9, y7 = x7 ^ y11, y17 = y10 ^ y11, y19 = y10 ^ y8;
+    W y16 = t0 ^ y11, y21 = y13 ^ y16, y18 = x0 ^ y16;
+
+    // inversion in GF(2^4)^2
+    W t2 = y12 & y15, t3 = y3 & y6, t4 = t3 ^ t2, t5 = y4 & x7, t6 = t5 ^ t2;
+    W t7 = y13 & y16, t8 = y5 & y1, t9 = t8 ^ t7, t10 = y2 & y7, t11 = t10 ^ t7;
+    W t12 = y9 & y11, t13 = y14 & y17, t14 = t13 ^ t12, t15 = y8 & y10, t16 = t15 ^ t12;
+    W t17 = t4 ^ t14, t18 = t6 ^ t16, t19 = t9 ^ t14, t20 = t11 ^ t16;
+    W t21 = t17 ^ y20, t22 = t18 ^ y19, t23 = t19 ^ y21, t24 = t20 ^ y18;
+    W t25 = t21 ^ t22, t26 = t21 & t23, t27 = t24 ^ t26, t28 = t25 & t27, t29 = t28 ^ t22;
+    W t30 = t23 ^ t24, t31 = t22 ^ t26, t32 = t31 & t30, t33 = t32 ^ t24, t34 = t23 ^ t33;
+    W t35 = t27 ^ t33, t36 = t24 & t35, t37 = t36 ^ t34, t38 = t27 ^ t36, t39 = t29 & t38;
+    W t40 = t25 ^ t39, t41 = t40 ^ t37, t42 = t29 ^ t33, t43 = t29 ^ t40;
+    W t44 = t33 ^ t37, t45 = t42 ^ t41;
+    W z0 = t44 & y15, z1 = t37 & y6, z2 = t33 & x7, z3 = t43 & y16, z4 = t40 & y1;
+    W z5 = t29 & y7, z6 = t42 & y11, z7 = t45 & y17, z8 = t41 & y10, z9 = t44 & y12;
+    W z10 = t37 & y3, z11 = t33 & y4, z12 = t43 & y13, z13 = t40 & y5, z14 = t29 & y2;
+    W z15 = t42 & y9, z16 = t45 & y14, z17 = t41 & y8;
+
+    // bottom linear transformation with the affine constant
+    W t46 = z15 ^ z16, t47 = z10 ^ z11, t48 = z5 ^ z13, t49 = z9 ^ z10, t50 = z2 ^ z12;
+    W t51 = z2 ^ z5, t52 = z7 ^ z8, t53 = z0 ^ z3, t54 = z6 ^ z7, t55 = z16 ^ z17;
+    W t56 = z12 ^ t48, t57 = t50 ^ t53, t58 = z4 ^ t46, t59 = z3 ^ t54, t60 = t46 ^ t57;
+    W t61 = z14 ^ t57, t62 = t52 ^ t58, t63 = t49 ^ t58, t64 = z4 ^ t59;
+    W t65 = t61 ^ t62, t66 = z1 ^ t63;
+    W s0 = t59 ^ t63, s6 = t56 ^ ~t62, s7 = t48 ^ ~t60, t67 = t64 ^ t65;
+    W s3 = t53 ^ t66, s4 = t51 ^ t66, s5 = t47 ^ t65, s1 = t64 ^ ~s3, s2 = t55 ^ ~t67;
+    q[7] = s0; q[6] = s1; q[5] = s2; q[4] = s3;
+    q[3] = s4; q[2] = s5; q[1] = s6; q[0] = s7;
+}
+
+// Inverse of the affine map A in S(x) = A(x^-1). Inversion is
+// its own inverse, so inverse S is A^-1 S A^-1
+static inline void inv_affine_sliced(Planes * q) {
+    Planes q0 = ~q[0], q1 = ~q[1], q2 = q[2], q3 = q[3];
+    Planes q4 = q[4], q5 = ~q[5], q6 = ~q[6], q7 = q[7];
+    q[7] = q1 ^ q4 ^ q6;
+    q[6] = q0 ^ q3 ^ q5;
+    q[5] = q7 ^ q2 ^ q4;
+    q[4] = q6 ^ q1 ^ q3;
+    q[3] = q5 ^ q0 ^ q2;
+    q[2] = q4 ^ q7 ^ q1;
+    q[1] = q3 ^ q6 ^ q0;
+    q[0] = q2 ^ q5 ^ q7;
+}
+
+static inline void inv_sbox_sliced(Planes * q) {
+    inv_affine_sliced(q);
+    sbox_sliced(q);
+    inv_affine_sliced(q);
+}
+
+static inline void add_round_key_sliced(Planes * q, const Planes * key) {
+    for(int i = 0; i < 8; i++) q[i] ^= key[i];
+}
+
+static inline void shift_rows_sliced(Planes * q) {
     for(int i = 0; i < 8; i++) {
-        byte next_bit =
-        (0x1 & affine_shift) ^ scalar_product(affine_matrix[i], b);
-        affine_shift >>= 1;
-        result |= next_bit << i;
+        Planes x = q[i];
+        q[i] = (x & 0x000000000000FFFFull)
+            | ((x & 0x00000000FFF00000ull) >> 4) | ((x & 0x00000000000F0000ull) << 12)
+            | ((x & 0x0000FF0000000000ull) >> 8) | ((x & 0x000000FF00000000ull) << 8)
+            | ((x & 0xF000000000000000ull) >> 12) | ((x & 0x0FFF000000000000ull) << 4);
     }
-    return result;
 }
-static byte inv_affine_transform(byte b) {
-    const byte affine_matrix[] = {
-		0xa4, 0x49, 0x92, 0x25, 0x4a, 0x94, 0x29, 0x52
-    };
-    byte affine_shift = 0x05;
 
-    byte result = 0;
+static inline void inv_shift_rows_sliced(Planes * q) {
     for(int i = 0; i < 8; i++) {
-        byte next_bit =
-        (0x1 & affine_shift) ^ scalar_product(affine_matrix[i], b);
-        affine_shift >>= 1;
-        result |= next_bit << i;
+        Planes x = q[i];
+        q[i] = (x & 0x000000000000FFFFull)
+            | ((x & 0x000000000FFF0000ull) << 4) | ((x & 0x00000000F0000000ull) >> 12)
+            | ((x & 0x000000FF00000000ull) << 8) | ((x & 0x0000FF0000000000ull) >> 8)
+            | ((x & 0x000F000000000000ull) << 12) | ((x & 0xFFF0000000000000ull) >> 4);
+    }
+}
+
+static inline Planes rotr16(Planes x) { return (x >> 16) | (x << 48); }
+static inline Planes rotr32(Planes x) { return (x >> 32) | (x << 32); }
+
+static inline void mix_columns_sliced(Planes * q) {
+    Planes q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    Planes q4 = q[4], q5 = q[5], q6 = q[6], q7 = q[7];
+    Planes r0 = rotr16(q0), r1 = rotr16(q1), r2 = rotr16(q2), r3 = rotr16(q3);
+    Planes r4 = rotr16(q4), r5 = rotr16(q5), r6 = rotr16(q6), r7 = rotr16(q7);
+
+    q[0] = q7 ^ r7 ^ r0 ^ rotr32(q0 ^ r0);
+    q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ rotr32(q1 ^ r1);
+    q[2] = q1 ^ r1 ^ r2 ^ rotr32(q2 ^ r2);
+    q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ rotr32(q3 ^ r3);
+    q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ rotr32(q4 ^ r4);
+    q[5] = q4 ^ r4 ^ r5 ^ rotr32(q5 ^ r5);
+    q[6] = q5 ^ r5 ^ r6 ^ rotr32(q6 ^ r6);
+    q[7] = q6 ^ r6 ^ r7 ^ rotr32(q7 ^ r7);
+}
+
+static inline void inv_mix_columns_sliced(Planes * q) {
+    Planes q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    Planes q4 = q[4], q5 = q[5], q6 = q[6], q7 = q[7];
+    Planes r0 = rotr16(q0), r1 = rotr16(q1), r2 = rotr16(q2), r3 = rotr16(q3);
+    Planes r4 = rotr16(q4), r5 = rotr16(q5), r6 = rotr16(q6), r7 = rotr16(q7);
+
+    q[0] = q5 ^ q6 ^ q7 ^ r0 ^ r5 ^ r7 ^ rotr32(q0 ^ q5 ^ q6 ^ r0 ^ r5);
+    q[1] = q0 ^ q5 ^ r0 ^ r1 ^ r5 ^ r6 ^ r7 ^ rotr32(q1 ^ q5 ^ q7 ^ r1 ^ r5 ^ r6);
+    q[2] = q0 ^ q1 ^ q6 ^ r1 ^ r2 ^ r6 ^ r7 ^ rotr32(q0 ^ q2 ^ q6 ^ r2 ^ r6 ^ r7);
+    q[3] = q0 ^ q1 ^ q2 ^ q5 ^ q6 ^ r0 ^ r2 ^ r3 ^ r5
+        ^ rotr32(q0 ^ q1 ^ q3 ^ q5 ^ q6 ^ q7 ^ r0 ^ r3 ^ r5 ^ r7);
+    q[4] = q1 ^ q2 ^ q3 ^ q5 ^ r1 ^ r3 ^ r4 ^ r5 ^ r6 ^ r7
+        ^ rotr32(q1 ^ q2 ^ q4 ^ q5 ^ q7 ^ r1 ^ r4 ^ r5 ^ r6);
+    q[5] = q2 ^ q3 ^ q4 ^ q6 ^ r2 ^ r4 ^ r5 ^ r6 ^ r7
+        ^ rotr32(q2 ^ q3 ^ q5 ^ q6 ^ r2 ^ r5 ^ r6 ^ r7);
+    q[6] = q3 ^ q4 ^ q5 ^ q7 ^ r3 ^ r5 ^ r6 ^ r7
+        ^ rotr32(q3 ^ q4 ^ q6 ^ q7 ^ r3 ^ r6 ^ r7);
+    q[7] = q4 ^ q5 ^ q6 ^ r4 ^ r6 ^ r7 ^ rotr32(q4 ^ q5 ^ q7 ^ r4 ^ r7);
+}
+
+// Swaps bits between pairs of planes, an involution
+static inline void ortho(Planes * q) {
+#define SWAP_BITS(mask, shift, x, y) do { \
+        Planes a = x, b = y; \
+        x = (a & mask) | ((b & mask) << shift); \
+        y = ((a >> shift) & mask) | (b & ~(mask)); \
+    } while(0)
+    for(int i = 0; i < 8; i += 2) SWAP_BITS(0x5555555555555555ull, 1, q[i], q[i + 1]);
+    for(int i = 0; i < 8; i += 4) {
+        SWAP_BITS(0x3333333333333333ull, 2, q[i], q[i + 2]);
+        SWAP_BITS(0x3333333333333333ull, 2, q[i + 1], q[i + 3]);
     }
+    for(int i = 0; i < 4; i++) SWAP_BITS(0x0F0F0F0F0F0F0F0Full, 4, q[i], q[i + 4]);
+#undef SWAP_BITS
+}
+
+// Block n goes to lane n / 4, its even dwords to plane n % 4 and odd
+// ones to plane n % 4 + 4, bytes of a dword spread over 16-bit rows
+static inline uint64_t spread(dword x0, dword x1) {
+    uint64_t a = x0, b = x1;
+    a = (a | a << 16) & 0x0000FFFF0000FFFFull;
+    b = (b | b << 16) & 0x0000FFFF0000FFFFull;
+    a = (a | a << 8) & 0x00FF00FF00FF00FFull;
+    b = (b | b << 8) & 0x00FF00FF00FF00FFull;
+    return a | b << 8;
+}
+
+static inline void gather(uint64_t x, dword & x0, dword & x1) {
+    uint64_t a = x & 0x00FF00FF00FF00FFull, b = (x >> 8) & 0x00FF00FF00FF00FFull;
+    a = (a | a >> 8) & 0x0000FFFF0000FFFFull;
+    b = (b | b >> 8) & 0x0000FFFF0000FFFFull;
+    x0 = dword(a | a >> 16);
+    x1 = dword(b | b >> 16);
+}
+
+static inline dword load_le(const byte * p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | dword(p[3]) << 24;
+}
+
+static inline void store_le(byte * p, dword x) {
+    p[0] = x; p[1] = x >> 8; p[2] = x >> 16; p[3] = x >> 24;
+}
+
+static void load_sliced(Planes * q, const byte * blocks) {
+    for(int n = 0; n < SLICED_BLOCKS; n++) {
+        const byte * block = blocks + 16 * n;
+        q[n % 4][n / 4] = spread(load_le(block), load_le(block + 8));
+        q[n % 4 + 4][n / 4] = spread(load_le(block + 4), load_le(block + 12));
+    }
+    ortho(q);
+}
+
+static void store_sliced(byte * blocks, Planes * q) {
+    ortho(q);
+    for(int n = 0; n < SLICED_BLOCKS; n++) {
+        byte * block = blocks + 16 * n;
+        dword w[4];
+        gather(q[n % 4][n / 4], w[0], w[2]);
+        gather(q[n % 4 + 4][n / 4], w[1], w[3]);
+        for(int c = 0; c < 4; c++) store_le(block + DWORD * c, w[c]);
+    }
+}
+
+// SubWord of the key schedule through the same circuit,
+// bytes of the word in the lowest bits of planes
+static dword sub_word_sliced(dword w) {
+    uint64_t q[8];
+    for(int i = 0; i < 8; i++) {
+        q[i] = 0;
+        for(int j = 0; j < DWORD; j++) q[i] |= uint64_t((w >> (8 * j + i)) & 1) << j;
+    }
+    sbox_sliced(q);
+    dword result = 0;
+    for(int i = 0; i < 8; i++)
+        for(int j = 0; j < DWORD; j++) result |= dword((q[i] >> j) & 1) << (8 * j + i);
     return result;
 }
 
+// A round key is sliced as if all 8 blocks were the key itself
+template <uint Nk, uint Nr>
+static void prepare_sliced(const byte * key, byte * schedule) {
+    dword w[4 * (Nr + 1)];
+    byte copies[16 * SLICED_BLOCKS];
+    Planes * keys = reinterpret_cast<Planes *>(schedule);
+
+    expand_key_words<Nk, Nr, sub_word_sliced>(key, w);
+    for(uint round = 0; round <= Nr; round++) {
+        for(int n = 0; n < SLICED_BLOCKS; n++)
+            for(int c = 0; c < 4; c++)
+                store_le(copies + 16 * n + DWORD * c, w[4 * round + c]);
+        load_sliced(keys + 8 * round, copies);
+    }
+    secure_zero(reinterpret_cast<byte *>(w), sizeof w);
+    secure_zero(copies, sizeof copies);
+}
+
+template <uint Nr>
+static void encrypt_sliced(Planes * q, const Planes * keys) {
+    add_round_key_sliced(q, keys);
+    for(uint round = 1; round < Nr; round++) {
+        sbox_sliced(q);
+        shift_rows_sliced(q);
+        mix_columns_sliced(q);
+        add_round_key_sliced(q, keys + 8 * round);
+    }
+    sbox_sliced(q);
+    shift_rows_sliced(q);
+    add_round_key_sliced(q, keys + 8 * Nr);
+}
+
+template <uint Nr>
+static void decrypt_sliced(Planes * q, const Planes * keys) {
+    add_round_key_sliced(q, keys + 8 * Nr);
+    for(int round = Nr - 1; round > 0; round--) {
+        inv_shift_rows_sliced(q);
+        inv_sbox_sliced(q);
+        add_round_key_sliced(q, keys + 8 * round);
+        inv_mix_columns_sliced(q);
+    }
+    inv_shift_rows_sliced(q);
+    inv_sbox_sliced(q);
+    add_round_key_sliced(q, keys);
+}
+
+// Whole groups of 8 in place, the tail through a padded copy
+template <uint Nr, bool Decrypt>
+static void run_sliced(byte * blocks, size_t count, const byte * schedule) {
+    const Planes * keys = reinterpret_cast<const Planes *>(schedule);
+    Planes q[8];
+    byte tail[16 * SLICED_BLOCKS];
+    size_t i = 0;
+    for(; i < count; i += SLICED_BLOCKS) {
+        size_t n_blocks = std::min<size_t>(SLICED_BLOCKS, count - i);
+        byte * group = n_blocks == SLICED_BLOCKS ? blocks + 16 * i : tail;
+        if(group == tail) {
+            memset(tail, 0, sizeof tail);
+            memcpy(tail, blocks + 16 * i, 16 * n_blocks);
+        }
+        load_sliced(q, group);
+        if(Decrypt) decrypt_sliced<Nr>(q, keys);
+        else encrypt_sliced<Nr>(q, keys);
+        store_sliced(group, q);
+        if(group == tail)
+            memcpy(blocks + 16 * i, tail, 16 * n_blocks);
+    }
+    secure_zero(reinterpret_cast<byte *>(q), sizeof q);
+    secure_zero(tail, sizeof tail);
+}
+
+AesEngine best_aes_engine() {
+    static const AesEngine best = aesni_supported() ? AesEngine::aesni : AesEngine::tables;
+    return best;
+}
+
+// ------------------------------- AES -----------------------------------
+// AES blocks (Nb = 4) go through one of the engines.
+// With tables they go by columns: a round is 16 lookups in T-tables,
+// the last one takes S straight with ShiftRows folded into the indices.
+// Round keys are words, those to encrypt with go first, then those of the
+// equivalent inverse cipher: the same in reverse order, InvMixColumns
+// applied to all but the outer two, so decryption runs like encryption.
+// prepare makes the first set, prepare_inverse the second one of it.
+// AES-NI keeps the same two sets as 128-bit registers. Bitsliced
+// rounds take one set of keys sliced into 8 planes each
+template <uint Nr>
+struct RijndaelRounds<4, Nr> {
+    static size_t schedule_size(AesEngine engine) {
+        return engine == AesEngine::bitsliced ?
+            (Nr + 1) * 8 * sizeof(Planes) : 2 * (Nr + 1) * 4 * sizeof(dword);
+    }
+
+    template <uint Nk>
+    static void prepare(const byte * key, byte * schedule, AesEngine engine);
+    static void prepare_inverse(byte * schedule, AesEngine engine);
+    static void encrypt(byte * blocks, size_t count, const byte * schedule, AesEngine engine);
+    static void decrypt(byte * blocks, size_t count, const byte * schedule, AesEngine engine);
+
+    template <int N>
+    static void encrypt_group(const RijndaelTables & tables, byte * blocks, const dword * keys);
+    template <int N>
+    static void decrypt_group(const RijndaelTables & tables, byte * blocks, const dword * keys);
+};
+
+template <uint Nr>
+template <uint Nk>
+void RijndaelRounds<4, Nr>::prepare(const byte * key, byte * schedule, AesEngine engine) {
+    if(engine == AesEngine::aesni) {
+        prepare_aesni<Nk, Nr>(key, schedule);
+        return;
+    }
+    if(engine == AesEngine::bitsliced) {
+        prepare_sliced<Nk, Nr>(key, schedule);
+        return;
+    }
+
+    const int n_words = 4 * (Nr + 1);
+    dword * keys = reinterpret_cast<dword *>(schedule);
+    byte w[n_words * DWORD];
+
+    key_expansion<Nk, 4, Nr>(key, w);
+    for(int i = 0; i < n_words; i++)
+        keys[i] = load_column(w + DWORD * i);
+    secure_zero(w, sizeof w);
+}
+
+template <uint Nr>
+void RijndaelRounds<4, Nr>::prepare_inverse(byte * schedule, AesEngine engine) {
+    if(engine == AesEngine::aesni) {
+        prepare_inverse_aesni<Nr>(schedule);
+        return;
+    }
+    if(engine == AesEngine::bitsliced)
+        return;
+
+    const RijndaelTables & tables = TABLES;
+    const int n_words = 4 * (Nr + 1);
+    dword * keys = reinterpret_cast<dword *>(schedule);
+    for(uint round = 0; round <= Nr; round++) {
+        for(int c = 0; c < 4; c++) {
+            dword column = keys[4 * (Nr - round) + c];
+            if(round != 0 && round != Nr) {
+                // td cancels S, which leaves InvMixColumns alone
+                column =
+                    tables.td[0][tables.sbox[column >> 24]] ^
+                    tables.td[1][tables.sbox[(column >> 16) & 0xff]] ^
+                    tables.td[2][tables.sbox[(column >> 8) & 0xff]] ^
+                    tables.td[3][tables.sbox[column & 0xff]];
+            }
+            keys[n_words + 4 * round + c] = column;
+        }
+    }
+}
+
+template <uint Nr>
+template <int N>
+void RijndaelRounds<4, Nr>::encrypt_group(const RijndaelTables & tables, byte * blocks, const dword * keys) {
+    dword s[N][4], t[N][4];
+    for(int n = 0; n < N; n++)
+        for(int c = 0; c < 4; c++)
+            s[n][c] = load_column(blocks + 16 * n + DWORD * c) ^ keys[c];
+
+    for(uint round = 1; round < Nr; round++) {
+        keys += 4;
+        for(int n = 0; n < N; n++) {
+            for(int c = 0; c < 4; c++) {
+                t[n][c] =
+                    tables.te[0][s[n][c] >> 24] ^
+                    tables.te[1][(s[n][(c + 1) % 4] >> 16) & 0xff] ^
+                    tables.te[2][(s[n][(c + 2) % 4] >> 8) & 0xff] ^
+                    tables.te[3][s[n][(c + 3) % 4] & 0xff] ^ keys[c];
+            }
+        }
+        memcpy(s, t, sizeof s);
+    }
+
+    keys += 4;
+    for(int n = 0; n < N; n++) {
+        for(int c = 0; c < 4; c++) {
+            dword column =
+                dword(tables.sbox[s[n][c] >> 24]) << 24 |
+                dword(tables.sbox[(s[n][(c + 1) % 4] >> 16) & 0xff]) << 16 |
+                dword(tables.sbox[(s[n][(c + 2) % 4] >> 8) & 0xff]) << 8 |
+                tables.sbox[s[n][(c + 3) % 4] & 0xff];
+            store_column(blocks + 16 * n + DWORD * c, column ^ keys[c]);
+        }
+    }
+}
+
+template <uint Nr>
+template <int N>
+void RijndaelRounds<4, Nr>::decrypt_group(const RijndaelTables & tables, byte * blocks, const dword * keys) {
+    dword s[N][4], t[N][4];
+    for(int n = 0; n < N; n++)
+        for(int c = 0; c < 4; c++)
+            s[n][c] = load_column(blocks + 16 * n + DWORD * c) ^ keys[c];
+
+    // InvShiftRows moves rows right, the indices go the other way round
+    for(uint round = 1; round < Nr; round++) {
+        keys += 4;
+        for(int n = 0; n < N; n++) {
+            for(int c = 0; c < 4; c++) {
+                t[n][c] =
+                    tables.td[0][s[n][c] >> 24] ^
+                    tables.td[1][(s[n][(c + 3) % 4] >> 16) & 0xff] ^
+                    tables.td[2][(s[n][(c + 2) % 4] >> 8) & 0xff] ^
+                    tables.td[3][s[n][(c + 1) % 4] & 0xff] ^ keys[c];
+            }
+        }
+        memcpy(s, t, sizeof s);
+    }
+
+    keys += 4;
+    for(int n = 0; n < N; n++) {
+        for(int c = 0; c < 4; c++) {
+            dword column =
+                dword(tables.invsbox[s[n][c] >> 24]) << 24 |
+                dword(tables.invsbox[(s[n][(c + 3) % 4] >> 16) & 0xff]) << 16 |
+                dword(tables.invsbox[(s[n][(c + 2) % 4] >> 8) & 0xff]) << 8 |
+                tables.invsbox[s[n][(c + 1) % 4] & 0xff];
+            store_column(blocks + 16 * n + DWORD * c, column ^ keys[c]);
+        }
+    }
+}
+
+// Blocks are taken by groups of INTERLEAVE which go through the rounds
+// together, so lookups of one block don't wait for the previous one
+static const int INTERLEAVE = 4;
+
+template <uint Nr>
+void RijndaelRounds<4, Nr>::encrypt(byte * blocks, size_t count, const byte * schedule, AesEngine engine) {
+    if(engine == AesEngine::aesni) {
+        run_aesni<Nr, false>(blocks, count, schedule);
+        return;
+    }
+    if(engine == AesEngine::bitsliced) {
+        run_sliced<Nr, false>(blocks, count, schedule);
+        return;
+    }
+    const RijndaelTables & tables = TABLES;
+    const dword * keys = reinterpret_cast<const dword *>(schedule);
+    size_t i = 0;
+    for(; i + INTERLEAVE <= count; i += INTERLEAVE)
+        encrypt_group<INTERLEAVE>(tables, blocks + 16 * i, keys);
+    for(; i < count; i++)
+        encrypt_group<1>(tables, blocks + 16 * i, keys);
+}
+
+template <uint Nr>
+void RijndaelRounds<4, Nr>::decrypt(byte * blocks, size_t count, const byte * schedule, AesEngine engine) {
+    if(engine == AesEngine::aesni) {
+        run_aesni<Nr, true>(blocks, count, schedule);
+        return;
+    }
+    if(engine == AesEngine::bitsliced) {
+        run_sliced<Nr, true>(blocks, count, schedule);
+        return;
+    }
+    const RijndaelTables & tables = TABLES;
+    const dword * keys = reinterpret_cast<const dword *>(schedule) + 4 * (Nr + 1);
+    size_t i = 0;
+    for(; i + INTERLEAVE <= count; i += INTERLEAVE)
+        decrypt_group<INTERLEAVE>(tables, blocks + 16 * i, keys);
+    for(; i < count; i++)
+        decrypt_group<1>(tables, blocks + 16 * i, keys);
+}
+
 // -------------------------- the Cipher Class ---------------------------
 
 template <uint Nk, uint Nb, uint Nr>
-Rijndael<Nk, Nb, Nr>::Rijndael(const ByteBlock & key) {
+Rijndael<Nk, Nb, Nr>::Rijndael(ByteView key, AesEngine engine_) :
+    engine(engine_), inverse_ready(false)
+{
     if(key.size() != Nk * DWORD) throw std::invalid_argument("Invalid key length");
+    if(engine == AesEngine::aesni && !aesni_supported())
+        engine = AesEngine::tables;
 
-    if( !SBoxContainer::is_init ) SBoxContainer::init();
-    if( !RConstContainer<Nr>::is_init ) RConstContainer<Nr>::init();
+    schedule = ByteBlock::cache_aligned(RijndaelRounds<Nb, Nr>::schedule_size(engine));
+    RijndaelRounds<Nb, Nr>::template prepare<Nk>(key.byte_ptr(), schedule.byte_ptr(), engine);
+}
 
-    round_keys.resize(Nr + 1);
-    key_expansion<Nk, Nb, Nr>(key.byte_ptr(), round_keys);
+template <uint Nk, uint Nb, uint Nr>
+Rijndael<Nk, Nb, Nr>::Rijndael(const Rijndael & rhs) :
+    inverse_ready(false)
+{
+    *this = rhs;
+}
+
+// Decryption keys of every cipher are made once in their life,
+// one lock for all of them will do. It is held for a key expansion
+// at most, spinning costs less than a mutex which may throw
+static std::atomic_flag making_inverse = ATOMIC_FLAG_INIT;
+
+namespace {
+struct InverseLock {
+    InverseLock() noexcept {
+        while(making_inverse.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+    ~InverseLock() {
+        making_inverse.clear(std::memory_order_release);
+    }
+};
 }
 
 template <uint Nk, uint Nb, uint Nr>
-Rijndael<Nk, Nb, Nr>::Rijndael(const Rijndael & rhs) {
-    for(auto & key : rhs.round_keys)
-        round_keys.push_back(key.deep_copy());
+Rijndael<Nk, Nb, Nr> & Rijndael<Nk, Nb, Nr>::operator = (const Rijndael & rhs) {
+    if(this == &rhs) return *this;
+    engine = rhs.engine;
+    if(rhs.inverse_ready.load(std::memory_order_acquire)) {
+        schedule = rhs.schedule.deep_copy();
+        inverse_ready.store(true, std::memory_order_release);
+        return *this;
+    }
+    // rhs may be making its decryption keys right now
+    InverseLock lock;
+    schedule = rhs.schedule.deep_copy();
+    bool ready = rhs.inverse_ready.load(std::memory_order_relaxed);
+    inverse_ready.store(ready, std::memory_order_release);
+    return *this;
 }
 
 template <uint Nk, uint Nb, uint Nr>
-void Rijndael<Nk, Nb, Nr>::encrypt(const ByteBlock & src, ByteBlock & dst) const {
-    if(src.size() != Nb * DWORD) throw std::invalid_argument("Invalid msg length");
+void Rijndael<Nk, Nb, Nr>::prepare_decryption() const noexcept {
+    if(inverse_ready.load(std::memory_order_acquire)) return;
 
-    if(dst != src) dst = src.deep_copy();
-    byte * target = dst.byte_ptr();
+    InverseLock lock;
+    if(inverse_ready.load(std::memory_order_relaxed)) return;
+    RijndaelRounds<Nb, Nr>::prepare_inverse(schedule.byte_ptr(), engine);
+    inverse_ready.store(true, std::memory_order_release);
+}
 
-    add_round_key<Nb>(target, round_keys[0].byte_ptr());
-    for(int i = 1; i < Nr; i++) {
-        sub_bytes<Nb>(target);
-        shift_rows<Nb>(target);
-        mix_columns<Nb>(target);
-        add_round_key<Nb>(target, round_keys[i].byte_ptr());
+template <uint Nk, uint Nb, uint Nr>
+void Rijndael<Nk, Nb, Nr>::encrypt_block(const uint8_t * in, uint8_t * out) const noexcept {
+    if(out != in) memcpy(out, in, block_lenght);
+    RijndaelRounds<Nb, Nr>::encrypt(out, 1, schedule.byte_ptr(), engine);
+}
+
+template <uint Nk, uint Nb, uint Nr>
+void Rijndael<Nk, Nb, Nr>::decrypt_block(const uint8_t * in, uint8_t * out) const noexcept {
+    prepare_decryption();
+    if(out != in) memcpy(out, in, block_lenght);
+    RijndaelRounds<Nb, Nr>::decrypt(out, 1, schedule.byte_ptr(), engine);
+}
+
+template <uint Nk, uint Nb, uint Nr>
+void Rijndael<Nk, Nb, Nr>::encrypt(ByteView src, ByteBlock & dst) const {
+    if(src.size() != Nb * DWORD) throw std::invalid_argument("Invalid msg length");
+
+    const uint8_t * in = src.byte_ptr();
+    // src may lie in dst, then it moves along with it
+    if(dst.size() != src.size()) {
+        dst.reset(in, src.size());
+        in = dst.byte_ptr();
     }
-    sub_bytes<Nb>(target);
-    shift_rows<Nb>(target);
-    add_round_key<Nb>(target, round_keys[Nr].byte_ptr());
+    encrypt_block(in, dst.byte_ptr());
 }
 
 template <uint Nk, uint Nb, uint Nr>
-void Rijndael<Nk, Nb, Nr>::decrypt(const ByteBlock & src, ByteBlock & dst) const {
+void Rijndael<Nk, Nb, Nr>::decrypt(ByteView src, ByteBlock & dst) const {
 	if(src.size() != Nb * DWORD) throw std::invalid_argument("Invalid msg length");
 
-    if(dst != src) dst = src.deep_copy();
-    byte * target = dst.byte_ptr();
+    const uint8_t * in = src.byte_ptr();
+    if(dst.size() != src.size()) {
+        dst.reset(in, src.size());
+        in = dst.byte_ptr();
+    }
+    decrypt_block(in, dst.byte_ptr());
+}
 
-	add_round_key<Nb>(target, round_keys[Nr].byte_ptr());
-	for(int i = Nr - 1; i > 0; i--) {
-		inv_shift_rows<Nb>(target);
-		inv_sub_bytes<Nb>(target);
-		add_round_key<Nb>(target, round_keys[i].byte_ptr());
-		inv_mix_columns<Nb>(target);
-	}
-	inv_shift_rows<Nb>(target);
-	inv_sub_bytes<Nb>(target);
-	add_round_key<Nb>(target, round_keys[0].byte_ptr());
+template <uint Nk, uint Nb, uint Nr>
+void Rijndael<Nk, Nb, Nr>::encrypt_blocks(const uint8_t * src, uint8_t * dst, size_t nblocks) const {
+    if(dst != src) memmove(dst, src, nblocks * block_lenght);
+    RijndaelRounds<Nb, Nr>::encrypt(dst, nblocks, schedule.byte_ptr(), engine);
+}
+
+template <uint Nk, uint Nb, uint Nr>
+void Rijndael<Nk, Nb, Nr>::decrypt_blocks(const uint8_t * src, uint8_t * dst, size_t nblocks) const {
+    if(dst != src) memmove(dst, src, nblocks * block_lenght);
+    prepare_decryption();
+    RijndaelRounds<Nb, Nr>::decrypt(dst, nblocks, schedule.byte_ptr(), engine);
 }
 
 
 // -------------------------- Transformations ---------------------------
 
 template <uint Nk, uint Nb, uint Nr>
-static void key_expansion(const byte * key, vector<ByteBlock> & round_keys) {
+static void key_expansion(const byte * key, byte * w) {
     byte tmp[DWORD];
-    byte w[Nb * (Nr + 1) * DWORD];
 
     for(int i = 0; i < Nk; i++)
         memcpy(w + DWORD * i, key + DWORD * i, DWORD);
@@ -188,26 +942,24 @@ static void key_expansion(const byte * key, vector<ByteBlock> & round_keys) {
         if(i % Nk == 0) {
             rot_word(tmp);
 			sub_word(tmp);
-			xor_n(tmp, tmp, (byte *) &RConstContainer<Nr>::rconst[i / Nk - 1], DWORD);
+			tmp[0] ^= TABLES.rconst[i / Nk - 1];
         } else if(Nk > 6 && i % Nk == 4) {
             sub_word(tmp);
         }
         xor_n(w + DWORD * i, w + DWORD * (i - Nk), tmp, DWORD);
     }
-
-    for(int i = 0; i < Nr + 1; i++)
-        round_keys[i].reset(w + i * Nb * DWORD, Nb * DWORD);
+    secure_zero(tmp, DWORD);
 }
 
 
 template <uint Nb>
 static void sub_bytes(byte * target) {
-	for(int i = 0; i < Nb * DWORD; i++) target[i] = SBoxContainer::sbox[target[i]];
+	for(int i = 0; i < Nb * DWORD; i++) target[i] = TABLES.sbox[target[i]];
 }
 
 template <uint Nb>
 static void inv_sub_bytes(byte * target) {
-	for(int i = 0; i < Nb * DWORD; i++) target[i] = SBoxContainer::invsbox[target[i]];
+	for(int i = 0; i < Nb * DWORD; i++) target[i] = TABLES.invsbox[target[i]];
 }
 
 template <uint Nb>
@@ -238,13 +990,13 @@ static void inv_shift_rows(byte * target_) {
 
 template <uint Nb>
 static void mix_columns(byte * target_) {
-	byte * tmp_ptr = new byte [16];
-	RijndaelState<Nb> tmp(tmp_ptr);
+	byte tmp_body[Nb * DWORD];
+	RijndaelState<Nb> tmp(tmp_body);
     RijndaelState<Nb> target(target_);
 
 	tmp = target;
 	for(int i = 0; i < Nb; i++) {
-		#define mul(x, y) multiply_field((x), (y), RIJNDAEL_MODULUS)
+		#define mul(x, y) GaloisField<RIJNDAEL_MODULUS>::multiply((x), (y))
 
 		target.at(0, i) =
 			mul(tmp.at(0, i), 0x2) ^ mul(tmp.at(1, i), 0x3) ^ tmp.at(2, i) ^ tmp.at(3, i);
@@ -257,18 +1009,17 @@ static void mix_columns(byte * target_) {
 
 		#undef mul
 	}
-	delete [] tmp_ptr;
 }
 
 template <uint Nb>
 static void inv_mix_columns(byte * target_) {
-	byte * tmp_ptr = new byte [16];
-	RijndaelState<Nb> tmp(tmp_ptr);
+	byte tmp_body[Nb * DWORD];
+	RijndaelState<Nb> tmp(tmp_body);
     RijndaelState<Nb> target(target_);
 
 	tmp = target;
 	for(int i = 0; i < Nb; i++) {
-		#define mul(x, y) multiply_field((x), (y), RIJNDAEL_MODULUS)
+		#define mul(x, y) GaloisField<RIJNDAEL_MODULUS>::multiply((x), (y))
 
 		target.at(0, i) =
 			mul(tmp.at(0, i), 0xe) ^ mul(tmp.at(1, i), 0xb) ^ mul(tmp.at(2, i), 0xd) ^ mul(tmp.at(3, i), 0x9);
@@ -281,21 +1032,20 @@ static void inv_mix_columns(byte * target_) {
 
 		#undef mul
 	}
-	delete [] tmp_ptr;
 }
 
 template <uint Nb>
 static void add_round_key(byte * target, const byte * round_key) {
-	xor_n(target, target, round_key, Nb * DWORD);
+	xor_inplace(target, round_key, Nb * DWORD);
 }
 
 static void sub_word(byte * target) {
-	for(int i = 0; i < DWORD; i++) target[i] = SBoxContainer::sbox[target[i]];
+	for(int i = 0; i < DWORD; i++) target[i] = TABLES.sbox[target[i]];
 }
 
 static void rot_word(byte * target) {
 	byte tmp = target[0];
-	for(int i = 0; i < DWORD; i++)
+	for(int i = 0; i < DWORD - 1; i++)
 		target[i] = target[i+1];
 	target[DWORD - 1] = tmp;
 }
@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include <MyCryptoLib/mycrypto.hpp>
 #include <MyCryptoLib/Stribog.hpp>
 #include <MyCryptoLib/rawbytes.hpp>
@@ -7,14 +9,14 @@ using namespace raw_bytes;
 #include <MyCryptoLib/StribogData.hpp>
 
 // ============================= Functions ================================== //
-void hash_function(byte * dst, byte const * msg, unsigned msg_len, byte iv_value);
+void hash_function(byte * dst, SegmentReader & msg, byte iv_value);
 void round_function(byte *, byte *, byte const *);
 // ---------------- Round Function Transformations -------------------------- //
 inline void tranform_composition(byte * target, byte const * mask);
 void substitution_transformation(byte * __restrict target);
 void permutation_transformation(byte * __restrict target);
 void linear_transformation_core(byte * __restrict target);
-void xor_transformation(byte * target __restrict, byte const * __restrict mask);
+void xor_transformation(byte * __restrict target, byte const * __restrict mask);
 // -------------------- Other Transformations ------------------------------- //
 void padding(byte * __restrict dst, byte const * __restrict src, unsigned len);
 void squared_add(byte * dst, byte const * lhs, byte const * rhs);
@@ -22,22 +24,34 @@ void squared_add(byte * dst, byte const * lhs, unsigned rhs_number);
 // ========================================================================== //
 
 // ======================= Stribog Hash Function ============================ //
-void Stribog512::hash(ByteBlock const & src, ByteBlock & dst) const
+void Stribog512::hash(ByteView src, ByteBlock & dst) const
+{
+    SegmentReader message(&src, 1);
+    hash(message, dst);
+}
+
+void Stribog512::hash(SegmentReader & src, ByteBlock & dst) const
 {
     byte hash_output [64];
-    hash_function(hash_output, src.byte_ptr(), src.size(), _iv);
+    hash_function(hash_output, src, _iv);
     dst.reset(hash_output, _hash_length);
 }
 
-void Stribog256::hash(ByteBlock const & src, ByteBlock & dst) const
+void Stribog256::hash(ByteView src, ByteBlock & dst) const
+{
+    SegmentReader message(&src, 1);
+    hash(message, dst);
+}
+
+void Stribog256::hash(SegmentReader & src, ByteBlock & dst) const
 {
     byte hash_output [64];
-    hash_function(hash_output, src.byte_ptr(), src.size(), _iv);
+    hash_function(hash_output, src, _iv);
     dst.reset(hash_output, _hash_length);
 }
 
 // ============================== Realization =============================== //
-void hash_function(byte * destination, byte const * message, unsigned msg_len, byte iv_value)
+void hash_function(byte * destination, SegmentReader & message, byte iv_value)
 {
     byte rf_parameter[64]       = {0};  // round function parameter N
     byte epsilon[64]            = {0};  // padding parameter EPSILON
@@ -45,24 +59,33 @@ void hash_function(byte * destination, byte const * message, unsigned msg_len, b
     byte intermidiate_hash[64];         // result of round function on every iter
     memset(intermidiate_hash, iv_value, sizeof intermidiate_hash);
 
+    unsigned msg_begin       = message.size() - message.remaining();
+    unsigned msg_len         = message.remaining();
     unsigned integral_parts  = msg_len >> 6;                     // msg_len / 64
     unsigned tail_part_len   = msg_len - (integral_parts << 6);  // integral_parts * 64
 
-    byte const * current_message = message + msg_len;
+    // blocks which span segments are gathered here
+    byte msg_buffer[64];
+    unsigned current_position = msg_begin + msg_len;
     // main loop of evaluating hash function
     for (int i = 0; i < integral_parts; i++)
     {
-        current_message -= 64;
+        current_position -= 64;
+        message.seek(current_position);
+        byte const * current_message = message.read(64, msg_buffer);
         round_function( intermidiate_hash,
                         rf_parameter,
                         current_message );
         squared_add(rf_parameter, rf_parameter, 512);
         squared_add(epsilon, epsilon, current_message);
     }
+    message.seek(msg_begin);
+    byte const * tail = message.read(tail_part_len, msg_buffer);
+    message.seek(msg_begin + msg_len);
 
     // last iteration
     byte padded_message[64] = {0};
-    padding(padded_message, message, tail_part_len);
+    padding(padded_message, tail, tail_part_len);
     round_function( intermidiate_hash,
                     rf_parameter,
                     padded_message  );
@@ -119,10 +142,9 @@ void linear_transformation(byte * __restrict target)
         linear_transformation_core(target + part * 8);
 }
 
-void xor_transformation(byte * __restrict target, byte const __restrict * mask)
+void xor_transformation(byte * __restrict target, byte const * __restrict mask)
 {
-    for(int i = 0; i < 64; i++)
-        target[i] ^= mask[i];
+    xor_inplace(target, mask, 64);
 }
 
 inline void split_into_bytes(byte * dst, unsigned x)
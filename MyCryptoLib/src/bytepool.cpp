@@ -0,0 +1,214 @@
+#include <atomic>
+#include <mutex>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+
+#include <MyCryptoLib/bytepool.hpp>
+
+// 128, 256, ..., 64K
+static const size_t N_CLASSES = 10;
+static const size_t LINK_SIZE = sizeof(BYTE *);
+
+static std::atomic<bool> pool_enabled(true);
+
+// Statistics are counted by every thread apart and only summed up
+// by statistics(), so the pool touches no shared cache lines on its way.
+// Only the owner thread writes its counters, a relaxed load and store
+// do without the locked read-modify-write of fetch_add
+struct Counter {
+    std::atomic<uint64_t> value;
+
+    Counter() : value(0) {}
+    void add(uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    void sub(uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) - n, std::memory_order_relaxed);
+    }
+    uint64_t get() const {
+        return value.load(std::memory_order_relaxed);
+    }
+};
+
+struct PoolCounters {
+    Counter hits;
+    Counter misses;
+    Counter bytes_held;
+};
+
+// Counts of threads gone and misses of those whose lists are gone,
+// shared but seldom touched
+static std::atomic<uint64_t> retired_hits(0);
+static std::atomic<uint64_t> retired_misses(0);
+// reset_statistics() leaves the counters running and moves these instead
+static std::atomic<uint64_t> hits_at_reset(0);
+static std::atomic<uint64_t> misses_at_reset(0);
+
+static size_t class_index(size_t size_) {
+    size_t index = 0;
+    for(size_t capacity = BytePool::min_class; capacity < size_; capacity <<= 1)
+        index++;
+    return index;
+}
+
+static size_t class_capacity(size_t index) {
+    return BytePool::min_class << index;
+}
+
+static BYTE * heap_acquire(size_t size_) {
+    void * ptr = nullptr;
+    if(posix_memalign(&ptr, BytePool::alignment, size_))
+        throw std::bad_alloc();
+    return static_cast<BYTE *>(ptr);
+}
+
+static void heap_release(BYTE * ptr) {
+    free(ptr);
+}
+
+// Blocks destroyed after the thread's lists (e.g. static ones)
+// go straight to the heap. The flag lives apart from the lists:
+// it has no destructor, so it may be read once they are gone
+static thread_local bool lists_are_dead = false;
+
+struct FreeLists;
+// Lists of living threads for statistics() to walk, the lock is taken
+// when a thread starts and ends using the pool and by statistics()
+static std::mutex registry_lock;
+static FreeLists * registry = nullptr;
+
+// Parked buffer keeps the pointer to the next one in its first bytes
+struct FreeLists {
+    BYTE * heads[N_CLASSES];
+    PoolCounters counters;
+    FreeLists * prev;
+    FreeLists * next;
+
+    FreeLists() : prev(nullptr) {
+        for(auto & head : heads) head = nullptr;
+        std::lock_guard<std::mutex> lock(registry_lock);
+        next = registry;
+        if(next) next->prev = this;
+        registry = this;
+    }
+    ~FreeLists() {
+        release_all();
+        lists_are_dead = true;
+
+        std::lock_guard<std::mutex> lock(registry_lock);
+        retired_hits.fetch_add(counters.hits.get(), std::memory_order_relaxed);
+        retired_misses.fetch_add(counters.misses.get(), std::memory_order_relaxed);
+        if(prev) prev->next = next;
+        else registry = next;
+        if(next) next->prev = prev;
+    }
+
+    BYTE * pop(size_t index) {
+        BYTE * ptr = heads[index];
+        if(!ptr) return nullptr;
+        memcpy(&heads[index], ptr, LINK_SIZE);
+        memset(ptr, 0, LINK_SIZE);
+        counters.bytes_held.sub(class_capacity(index));
+        return ptr;
+    }
+    void push(BYTE * ptr, size_t index) {
+        memcpy(ptr, &heads[index], LINK_SIZE);
+        heads[index] = ptr;
+        counters.bytes_held.add(class_capacity(index));
+    }
+    void release_all() {
+        for(size_t i = 0; i < N_CLASSES; i++) {
+            while(BYTE * ptr = pop(i)) heap_release(ptr);
+        }
+    }
+};
+
+static thread_local FreeLists free_lists;
+
+static void count_miss() {
+    if(lists_are_dead) retired_misses.fetch_add(1, std::memory_order_relaxed);
+    else free_lists.counters.misses.add(1);
+}
+
+size_t BytePool::capacity_for(size_t size_) {
+    if(size_ > max_class) return size_;
+    return class_capacity(class_index(size_));
+}
+
+BYTE * BytePool::acquire(size_t size_) {
+    if(size_ > max_class) {
+        count_miss();
+        return heap_acquire(size_);
+    }
+
+    // Pooled sizes are always rounded up to their class, so a buffer
+    // allocated while the pool was off may be parked later on
+    size_t index = class_index(size_);
+    if(pool_enabled.load(std::memory_order_relaxed) && !lists_are_dead) {
+        BYTE * ptr = free_lists.pop(index);
+        if(ptr) {
+            free_lists.counters.hits.add(1);
+            return ptr;
+        }
+    }
+    count_miss();
+    return heap_acquire(class_capacity(index));
+}
+
+void BytePool::recycle(BYTE * ptr, size_t size_) {
+    if(!ptr) return;
+    if( size_ > max_class ||
+        !pool_enabled.load(std::memory_order_relaxed) ||
+        lists_are_dead )
+    {
+        heap_release(ptr);
+        return;
+    }
+
+    size_t index = class_index(size_);
+    if(free_lists.counters.bytes_held.get() + class_capacity(index) > max_bytes_per_thread) {
+        heap_release(ptr);
+        return;
+    }
+    free_lists.push(ptr, index);
+}
+
+void BytePool::set_enabled(bool value) {
+    pool_enabled = value;
+}
+
+bool BytePool::enabled() {
+    return pool_enabled;
+}
+
+void BytePool::trim() {
+    if(!lists_are_dead) free_lists.release_all();
+}
+
+static BytePoolStats running_totals() {
+    BytePoolStats stats;
+    std::lock_guard<std::mutex> lock(registry_lock);
+    stats.hits = retired_hits.load(std::memory_order_relaxed);
+    stats.misses = retired_misses.load(std::memory_order_relaxed);
+    stats.bytes_held = 0;
+    for(FreeLists * lists = registry; lists; lists = lists->next) {
+        stats.hits += lists->counters.hits.get();
+        stats.misses += lists->counters.misses.get();
+        stats.bytes_held += lists->counters.bytes_held.get();
+    }
+    return stats;
+}
+
+BytePoolStats BytePool::statistics() {
+    BytePoolStats stats = running_totals();
+    stats.hits -= hits_at_reset.load(std::memory_order_relaxed);
+    stats.misses -= misses_at_reset.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void BytePool::reset_statistics() {
+    BytePoolStats stats = running_totals();
+    hits_at_reset = stats.hits;
+    misses_at_reset = stats.misses;
+}
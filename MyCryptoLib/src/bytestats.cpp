@@ -0,0 +1,120 @@
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#include <MyCryptoLib/bytestats.hpp>
+
+static bool enabled_from_start() {
+#ifdef MYCRYPTO_ACCOUNTING
+    return true;
+#else
+    const char * value = getenv("MYCRYPTO_ACCOUNTING");
+    return value && *value && strcmp(value, "0");
+#endif
+}
+
+static std::atomic<bool> stats_enabled(enabled_from_start());
+
+struct GlobalCounters {
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> bytes_allocated;
+    std::atomic<uint64_t> deep_copies;
+    std::atomic<uint64_t> bytes_copied;
+    std::atomic<uint64_t> wipes;
+    std::atomic<uint64_t> bytes_wiped;
+    std::atomic<int64_t> live_bytes;
+    std::atomic<int64_t> peak_live_bytes;
+};
+
+// zero initialized before any dynamic initialization takes place
+static GlobalCounters global_counters;
+static thread_local ByteCounters thread_counters;
+
+static void raise_peak(std::atomic<int64_t> & peak, int64_t value) {
+    int64_t current = peak.load(std::memory_order_relaxed);
+    while(value > current &&
+          !peak.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+        // current is reloaded by compare_exchange
+    }
+}
+
+void ByteStats::set_enabled(bool value) {
+    stats_enabled = value;
+}
+
+bool ByteStats::enabled() {
+    return stats_enabled;
+}
+
+ByteCounters ByteStats::global() {
+    ByteCounters counters;
+    counters.allocations = global_counters.allocations;
+    counters.bytes_allocated = global_counters.bytes_allocated;
+    counters.deep_copies = global_counters.deep_copies;
+    counters.bytes_copied = global_counters.bytes_copied;
+    counters.wipes = global_counters.wipes;
+    counters.bytes_wiped = global_counters.bytes_wiped;
+    counters.live_bytes = global_counters.live_bytes;
+    counters.peak_live_bytes = global_counters.peak_live_bytes;
+    return counters;
+}
+
+ByteCounters ByteStats::this_thread() {
+    return thread_counters;
+}
+
+void ByteStats::reset() {
+    global_counters.allocations = 0;
+    global_counters.bytes_allocated = 0;
+    global_counters.deep_copies = 0;
+    global_counters.bytes_copied = 0;
+    global_counters.wipes = 0;
+    global_counters.bytes_wiped = 0;
+    global_counters.peak_live_bytes = global_counters.live_bytes.load();
+
+    int64_t live_bytes = thread_counters.live_bytes;
+    memset(&thread_counters, 0, sizeof thread_counters);
+    thread_counters.live_bytes = live_bytes;
+    thread_counters.peak_live_bytes = live_bytes;
+}
+
+void ByteStats::on_allocate(size_t n_bytes) {
+    if(!stats_enabled.load(std::memory_order_relaxed)) return;
+
+    global_counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    global_counters.bytes_allocated.fetch_add(n_bytes, std::memory_order_relaxed);
+    int64_t live = global_counters.live_bytes.fetch_add(n_bytes, std::memory_order_relaxed) + n_bytes;
+    raise_peak(global_counters.peak_live_bytes, live);
+
+    thread_counters.allocations++;
+    thread_counters.bytes_allocated += n_bytes;
+    thread_counters.live_bytes += n_bytes;
+    if(thread_counters.live_bytes > thread_counters.peak_live_bytes)
+        thread_counters.peak_live_bytes = thread_counters.live_bytes;
+}
+
+void ByteStats::on_release(size_t n_bytes) {
+    if(!stats_enabled.load(std::memory_order_relaxed)) return;
+
+    global_counters.live_bytes.fetch_sub(n_bytes, std::memory_order_relaxed);
+    thread_counters.live_bytes -= n_bytes;
+}
+
+void ByteStats::on_copy(size_t n_bytes) {
+    if(!stats_enabled.load(std::memory_order_relaxed)) return;
+
+    global_counters.deep_copies.fetch_add(1, std::memory_order_relaxed);
+    global_counters.bytes_copied.fetch_add(n_bytes, std::memory_order_relaxed);
+    thread_counters.deep_copies++;
+    thread_counters.bytes_copied += n_bytes;
+}
+
+void ByteStats::on_wipe(size_t n_bytes) {
+    if(!stats_enabled.load(std::memory_order_relaxed)) return;
+
+    global_counters.wipes.fetch_add(1, std::memory_order_relaxed);
+    global_counters.bytes_wiped.fetch_add(n_bytes, std::memory_order_relaxed);
+    thread_counters.wipes++;
+    thread_counters.bytes_wiped += n_bytes;
+}
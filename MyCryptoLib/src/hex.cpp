@@ -0,0 +1,280 @@
+#include <stdexcept>
+
+#include <string>
+using std::string;
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include <MyCryptoLib/mycrypto.hpp>
+#include <MyCryptoLib/useful.hpp>
+
+// ------------------------------ Tables ------------------------------------
+
+static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+static constexpr BYTE NOT_A_DIGIT = 0xff;
+
+struct HexTables {
+    char encode[256][2];
+    BYTE decode[256];
+};
+
+static constexpr BYTE hex_value(unsigned symbol) {
+    return symbol >= '0' && symbol <= '9' ? symbol - '0' :
+           symbol >= 'a' && symbol <= 'f' ? symbol - 'a' + 10 :
+           symbol >= 'A' && symbol <= 'F' ? symbol - 'A' + 10 :
+           NOT_A_DIGIT;
+}
+
+template <size_t... I>
+static constexpr HexTables make_hex_tables(Indices<I...>) {
+    return HexTables {
+        { { HEX_DIGITS[I >> 4], HEX_DIGITS[I & 0xF] }... },
+        { hex_value(I)... }
+    };
+}
+
+// Computed by the compiler: codecs called from static initializers
+// of other files find them ready
+static constexpr HexTables hex_tables = make_hex_tables(MakeIndices<256>::type());
+
+static BYTE from_hex_literal(char symbol) {
+    BYTE value = hex_tables.decode[static_cast<BYTE>(symbol)];
+    if(value == NOT_A_DIGIT)
+        throw std::invalid_argument("from_hex_literal: " + std::to_string(symbol));
+    return value;
+}
+
+// ------------------------------ Scalar ------------------------------------
+
+static void encode_scalar(const BYTE * src, size_t n_bytes, char * dst) {
+    for(size_t i = 0; i < n_bytes; i++) {
+        memcpy(dst + 2 * i, hex_tables.encode[src[i]], 2);
+    }
+}
+
+static void decode_scalar(char const * s, size_t n_bytes, BYTE * dst) {
+    for(size_t i = 0; i < n_bytes; i++) {
+        dst[i] = (from_hex_literal(s[2 * i]) << 4) | from_hex_literal(s[2 * i + 1]);
+    }
+}
+
+// ------------------------------- SIMD -------------------------------------
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("ssse3")))
+static void encode_ssse3(const BYTE * src, size_t n_bytes, char * dst) {
+    const __m128i digits = _mm_loadu_si128(reinterpret_cast<const __m128i *>(HEX_DIGITS));
+    const __m128i low_nibble = _mm_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for(; i + 16 <= n_bytes; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), low_nibble));
+        __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(bytes, low_nibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    encode_scalar(src + i, n_bytes - i, dst + 2 * i);
+}
+
+// Turns 16 hex digits into their values, returns mask of valid ones
+__attribute__((target("ssse3")))
+static inline __m128i nibbles_ssse3(__m128i chars, int & valid) {
+    __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i is_digit = _mm_and_si128(
+        _mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+        _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), chars)
+    );
+    __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+    __m128i letter = _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10));
+    __m128i is_letter = _mm_and_si128(
+        _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+        _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), lower)
+    );
+    valid = _mm_movemask_epi8(_mm_or_si128(is_digit, is_letter));
+    return _mm_or_si128(_mm_and_si128(is_digit, digit), _mm_and_si128(is_letter, letter));
+}
+
+__attribute__((target("ssse3")))
+static void decode_ssse3(char const * s, size_t n_bytes, BYTE * dst) {
+    const __m128i weights = _mm_set1_epi16(0x0110);  // hi * 16 + lo * 1
+
+    size_t i = 0;
+    for(; i + 16 <= n_bytes; i += 16) {
+        int valid_a, valid_b;
+        __m128i a = nibbles_ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 2 * i)), valid_a);
+        __m128i b = nibbles_ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 2 * i + 16)), valid_b);
+        if((valid_a & valid_b) != 0xffff) break;  // let the scalar code report it
+        __m128i bytes = _mm_packus_epi16(_mm_maddubs_epi16(a, weights), _mm_maddubs_epi16(b, weights));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), bytes);
+    }
+    decode_scalar(s + 2 * i, n_bytes - i, dst + i);
+}
+
+__attribute__((target("avx2")))
+static void encode_avx2(const BYTE * src, size_t n_bytes, char * dst) {
+    const __m256i digits = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(HEX_DIGITS))
+    );
+    const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for(; i + 32 <= n_bytes; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), low_nibble));
+        __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(bytes, low_nibble));
+        // unpacks work inside 128-bit lanes, put the halves back in order
+        __m256i first = _mm256_unpacklo_epi8(hi, lo);
+        __m256i second = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 2 * i),
+                            _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 2 * i + 32),
+                            _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    encode_ssse3(src + i, n_bytes - i, dst + 2 * i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i nibbles_avx2(__m256i chars, unsigned & valid) {
+    __m256i digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    __m256i is_digit = _mm256_and_si256(
+        _mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars)
+    );
+    __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+    __m256i letter = _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10));
+    __m256i is_letter = _mm256_and_si256(
+        _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower)
+    );
+    valid = _mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter));
+    return _mm256_or_si256(_mm256_and_si256(is_digit, digit), _mm256_and_si256(is_letter, letter));
+}
+
+__attribute__((target("avx2")))
+static void decode_avx2(char const * s, size_t n_bytes, BYTE * dst) {
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+
+    size_t i = 0;
+    for(; i + 32 <= n_bytes; i += 32) {
+        unsigned valid_a, valid_b;
+        __m256i a = nibbles_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 2 * i)), valid_a);
+        __m256i b = nibbles_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + 2 * i + 32)), valid_b);
+        if((valid_a & valid_b) != 0xffffffffu) break;
+        // packus works inside 128-bit lanes as well
+        __m256i bytes = _mm256_packus_epi16(_mm256_maddubs_epi16(a, weights), _mm256_maddubs_epi16(b, weights));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_permute4x64_epi64(bytes, 0xD8));
+    }
+    decode_ssse3(s + 2 * i, n_bytes - i, dst + i);
+}
+
+typedef void (*hex_encoder)(const BYTE *, size_t, char *);
+typedef void (*hex_decoder)(char const *, size_t, BYTE *);
+
+struct HexKernels {
+    hex_encoder encode;
+    hex_decoder decode;
+
+    HexKernels() : encode(encode_scalar), decode(decode_scalar) {
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx2")) {
+            encode = encode_avx2;
+            decode = decode_avx2;
+        } else if(__builtin_cpu_supports("ssse3")) {
+            encode = encode_ssse3;
+            decode = decode_ssse3;
+        }
+    }
+};
+
+static const HexKernels & hex_kernels() {
+    static const HexKernels kernels;
+    return kernels;
+}
+
+static void encode(const BYTE * src, size_t n_bytes, char * dst) {
+    hex_kernels().encode(src, n_bytes, dst);
+}
+static void decode(char const * s, size_t n_bytes, BYTE * dst) {
+    hex_kernels().decode(s, n_bytes, dst);
+}
+
+#else
+
+static void encode(const BYTE * src, size_t n_bytes, char * dst) {
+    encode_scalar(src, n_bytes, dst);
+}
+static void decode(char const * s, size_t n_bytes, BYTE * dst) {
+    decode_scalar(s, n_bytes, dst);
+}
+
+#endif
+
+// ---------------------------- Interface -----------------------------------
+
+void hex_encode(ByteView bb, char * dst) {
+    encode(bb.byte_ptr(), bb.size(), dst);
+}
+
+void hex_representation(ByteView bb, string & dst) {
+    dst.resize(2 * bb.size());
+    if(bb.size()) encode(bb.byte_ptr(), bb.size(), &dst[0]);
+}
+
+string hex_representation(ByteView bb) {
+    string result;
+    hex_representation(bb, result);
+    return result;
+}
+
+void hex_to_bytes(char const * s, size_t length, ByteBlock & dst) {
+    if(length % 2) throw std::invalid_argument("length of hex-string must be even number");
+    dst.resize(length / 2);
+    decode(s, length / 2, dst.byte_ptr());
+}
+
+ByteBlock hex_to_bytes(char const * s, unsigned length, Sensitivity tag)
+{
+    ByteBlock result;
+    result.set_sensitivity(tag);
+    hex_to_bytes(s, length, result);
+    return result;
+}
+
+ByteBlock hex_to_bytes(const string & s, Sensitivity tag) {
+    return hex_to_bytes(s.c_str(), s.size(), tag);
+}
+
+HexDecoder::HexDecoder() :
+    pending_nibble(-1)
+{
+    // nothing
+}
+
+size_t HexDecoder::update(char const * s, size_t length, BYTE * dst) {
+    size_t written = 0;
+    if(length && pending_nibble >= 0) {
+        dst[written++] = (pending_nibble << 4) | from_hex_literal(*s);
+        pending_nibble = -1;
+        s++;
+        length--;
+    }
+
+    decode(s, length / 2, dst + written);
+    written += length / 2;
+
+    if(length % 2) pending_nibble = from_hex_literal(s[length - 1]);
+    return written;
+}
+
+void HexDecoder::finish() {
+    if(pending_nibble >= 0) {
+        pending_nibble = -1;
+        throw std::invalid_argument("length of hex-string must be even number");
+    }
+}
@@ -1,6 +1,7 @@
 #include <stdexcept>
 #include <vector>
 #include <cstdio>
+#include <cstring>
 
 #include <MyCryptoLib/Rijndael.hpp>
 #include <MyCryptoLib/mycrypto.hpp>
@@ -19,17 +20,17 @@ static void UnwrapCipherFunction(std::vector<ByteBlock> & rv, ByteBlock & a, Byt
 static void WrapShift(std::vector<ByteBlock> & semiblocks);
 static void UnwrapShift(std::vector<ByteBlock> & semiblocks);
 
-static void WrapFunction(ByteBlock & dst, const ByteBlock & str, const ByteBlock & key);
-static void UnwrapFunction(ByteBlock & dst, const ByteBlock & str, const ByteBlock & key);
+static void WrapFunction(ByteBlock & dst, ByteView str, ByteView key);
+static void UnwrapFunction(ByteBlock & dst, ByteView str, ByteView key);
 
-static void KwpPad(ByteBlock & dst, const ByteBlock & str);
+static void KwpPad(ByteBlock & dst, ByteView str);
 static void KuwpPad(ByteBlock & block);
 
-static void CheckStringToWrap( const ByteBlock & str );
-static void XorWithInt64(ByteBlock & rv, const ByteBlock & block, uint64_t integer);
+static void CheckStringToWrap( ByteView str );
+static void XorWithInt64(ByteBlock & rv, ByteView block, uint64_t integer);
 
 /* -------------------------------------- Key Wrap Functions ------------------------------------- */
-void KeyWrapFunction(ByteBlock & dst, const ByteBlock & str, const ByteBlock & key) {
+void KeyWrapFunction(ByteBlock & dst, ByteView str, ByteView key) {
     static unsigned char pad[] = {
         0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6
     };
@@ -42,22 +43,25 @@ void KeyWrapFunction(ByteBlock & dst, const ByteBlock & str, const ByteBlock & k
     temp.back() = str.deep_copy();
 
     WrapFunction(dst, join_blocks(temp), key);
+    dst.set_sensitivity(Sensitivity::nonsensitive);
 }
 
-void KeyUnwrapFunction(ByteBlock & dst, const ByteBlock & src, const ByteBlock & key) {
+void KeyUnwrapFunction(ByteBlock & dst, ByteView src, ByteView key) {
     static unsigned char pad[] = {
         0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6
     };
     size_t padlen = sizeof pad;
 
+    // the key lands in dst at once, it has to be wiped whatever happens next
+    dst.set_sensitivity(Sensitivity::sensitive);
     UnwrapFunction(dst, src, key);
     if(memcmp(dst.byte_ptr(), pad, padlen)) {
         throw std::invalid_argument("Failed to unwrap key");
     }
-    dst = dst(padlen, dst.size() - padlen);
+    dst = ByteBlock(dst(padlen, dst.size() - padlen));
 }
 
-void KeyWrapPaddedFunction(ByteBlock & dst, const ByteBlock & str, const ByteBlock & key) {
+void KeyWrapPaddedFunction(ByteBlock & dst, ByteView str, ByteView key) {
     KwpPad(dst, str);
     if(str.size() <= 8) {
         AES256 alg(key);
@@ -65,12 +69,14 @@ void KeyWrapPaddedFunction(ByteBlock & dst, const ByteBlock & str, const ByteBlo
     } else {
         WrapFunction(dst, dst, key);
     }
+    dst.set_sensitivity(Sensitivity::nonsensitive);
 }
 
-void KeyUnwrapPaddedFunction(ByteBlock & dst, const ByteBlock & str, const ByteBlock & key) {
+void KeyUnwrapPaddedFunction(ByteBlock & dst, ByteView str, ByteView key) {
     if(str.size() % HALFED_WCB)
         throw std::invalid_argument("String to wraped must be divisible by 64 block");
 
+    dst.set_sensitivity(Sensitivity::sensitive);
     if(str.size() / HALFED_WCB == 2) {
         AES256 alg(key);
         alg.decrypt(str, dst);
@@ -81,7 +87,7 @@ void KeyUnwrapPaddedFunction(ByteBlock & dst, const ByteBlock & str, const ByteB
 }
 /* ----------------------------------------------------------------------------------------------- */
 
-void WrapFunction(ByteBlock & dst, const ByteBlock & str, const ByteBlock & key) {
+void WrapFunction(ByteBlock & dst, ByteView str, ByteView key) {
     CheckStringToWrap(str);
 
     size_t n_semiblocks = str.size() / HALFED_WCB;
@@ -97,13 +103,15 @@ void WrapFunction(ByteBlock & dst, const ByteBlock & str, const ByteBlock & key)
         semiblocks.back() = std::move(ciphered.back());
     }
 
-    dst = join_blocks(semiblocks);
+    join_blocks(semiblocks, dst);
 }
 
-void UnwrapFunction(ByteBlock & dst, const ByteBlock & str, const ByteBlock & key) {
+void UnwrapFunction(ByteBlock & dst, ByteView str, ByteView key) {
     size_t n_semiblocks = str.size() / HALFED_WCB;
     size_t n_iter = 6 * (n_semiblocks - 1);
     auto semiblocks = split_blocks(str, HALFED_WCB);
+    for(auto & semiblock : semiblocks)
+        semiblock.set_sensitivity(Sensitivity::sensitive);
 
     AES256 alg(key);
     std::vector<ByteBlock> ciphered(2);
@@ -114,7 +122,7 @@ void UnwrapFunction(ByteBlock & dst, const ByteBlock & str, const ByteBlock & ke
         semiblocks[1] = std::move(ciphered.back());
     }
 
-    dst = join_blocks(semiblocks);
+    join_blocks(semiblocks, dst);
 }
 
 void WrapCipherFunction(std::vector<ByteBlock> & rv, ByteBlock & a, ByteBlock & b, uint64_t iter, const AES256 & alg) {
@@ -122,7 +130,7 @@ void WrapCipherFunction(std::vector<ByteBlock> & rv, ByteBlock & a, ByteBlock &
     rv.back() = std::move(b);
 
     ByteBlock to_encrypt(join_blocks(rv));
-    alg.encrypt(to_encrypt, to_encrypt);
+    alg.encrypt_block(to_encrypt.byte_ptr(), to_encrypt.byte_ptr());
     rv = split_blocks(to_encrypt, HALFED_WCB);
     XorWithInt64(rv[0], rv[0], iter);
 }
@@ -132,7 +140,8 @@ void UnwrapCipherFunction(std::vector<ByteBlock> & rv, ByteBlock & a, ByteBlock
     rv.back() = std::move(b);
 
     ByteBlock to_decrypt(join_blocks(rv));
-    alg.decrypt(to_decrypt, to_decrypt);
+    to_decrypt.set_sensitivity(Sensitivity::sensitive);
+    alg.decrypt_block(to_decrypt.byte_ptr(), to_decrypt.byte_ptr());
     rv = split_blocks(to_decrypt, HALFED_WCB);
 }
 
@@ -148,7 +157,7 @@ void UnwrapShift(std::vector<ByteBlock> & semiblocks) {
         semiblocks[i + 1] = std::move(semiblocks[i]);
 }
 
-void KwpPad(ByteBlock & dst, const ByteBlock & str) {
+void KwpPad(ByteBlock & dst, ByteView str) {
     std::vector<ByteBlock> result(4);
 
     static unsigned char padvalue[] = {
@@ -195,18 +204,18 @@ void KuwpPad(ByteBlock & block) {
     plen = __builtin_bswap32(plen);
 
     padlen = (block.size() / HALFED_WCB - 1) * 8 - plen;
-    if(!padlen || padlen > 7)
+    if(padlen > 7)
         throw std::invalid_argument("Failed to unwrap key");
 
-    ByteBlock tmp = block(block.size() - padlen, padlen);
+    ByteView tmp = block(block.size() - padlen, padlen);
     for(size_t i = 0; i < padlen; i++)
         if(tmp[i] != 0)
             throw std::invalid_argument("Failed to unwrap key");
 
-    block = block(HALFED_WCB, block.size() - HALFED_WCB - padlen);
+    block = ByteBlock(block(HALFED_WCB, block.size() - HALFED_WCB - padlen));
 }
 
-void CheckStringToWrap( const ByteBlock & str ) {
+void CheckStringToWrap( ByteView str ) {
     if(str.size() % HALFED_WCB)
        throw std::invalid_argument("String to wraped must be divisible by 64 block");
 
@@ -215,9 +224,9 @@ void CheckStringToWrap( const ByteBlock & str ) {
        throw std::invalid_argument("String to wraped must be larger");
 }
 
-void XorWithInt64(ByteBlock & rv, const ByteBlock & block, uint64_t integer) {
+void XorWithInt64(ByteBlock & rv, ByteView block, uint64_t integer) {
     unsigned char bytes[sizeof integer];
     integer = __builtin_bswap64(integer);
     memcpy(bytes, &integer, sizeof integer);
-    xor_blocks(rv, block, ByteBlock(bytes, sizeof bytes));
+    xor_blocks(rv, block, ByteView(bytes, sizeof bytes));
 }
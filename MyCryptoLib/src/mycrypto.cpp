@@ -1,57 +1,168 @@
 #include <stdexcept>
 
-#include <sstream>
-using std::stringstream;
-
-#include <string>
-using std::string;
-using std::getline;
-
 #include <vector>
 using std::vector;
 
 #include <cstring>
 
+#include <algorithm>
+
+#include <atomic>
+
 #include <MyCryptoLib/mycrypto.hpp>
+#include <MyCryptoLib/bytepool.hpp>
+#include <MyCryptoLib/bytestats.hpp>
+#include <MyCryptoLib/rawbytes.hpp>
+
+static std::atomic<WipePolicy> global_wipe_policy(WipePolicy::sensitive_only);
+
+ByteView::ByteView() :
+    pBlocks(nullptr), amount_of_bytes(0)
+{
+    // nothing
+}
+ByteView::ByteView(const BYTE * pBlocks_, size_t size_) :
+    pBlocks(pBlocks_), amount_of_bytes(size_)
+{
+    // nothing
+}
+ByteView::ByteView(const ByteBlock & bb) :
+    pBlocks(bb.byte_ptr()), amount_of_bytes(bb.size())
+{
+    // nothing
+}
+
+const BYTE * ByteView::byte_ptr() const {
+    return pBlocks;
+}
+
+BYTE ByteView::operator [] (size_t index) const {
+    return *(pBlocks + index);
+}
+
+size_t ByteView::size() const {
+    return amount_of_bytes;
+}
+
+ByteBlock ByteView::deep_copy() const {
+    return ByteBlock(pBlocks, amount_of_bytes);
+}
+
+ByteView ByteView::operator () (size_t begin, size_t length) const {
+    return ByteView(pBlocks + begin, length);
+}
+
+MutableByteView::MutableByteView(BYTE * pBlocks_, size_t size_) :
+    pBlocks(pBlocks_), amount_of_bytes(size_)
+{
+    // nothing
+}
+MutableByteView::MutableByteView(ByteBlock & bb) :
+    pBlocks(bb.byte_ptr()), amount_of_bytes(bb.size())
+{
+    // nothing
+}
+
+BYTE * MutableByteView::byte_ptr() const {
+    return pBlocks;
+}
+
+size_t MutableByteView::size() const {
+    return amount_of_bytes;
+}
 
 ByteBlock::ByteBlock(size_t size_, BYTE init_value) :
-    amount_of_bytes(size_)
+    aligned_body(false), sensitivity_tag(Sensitivity::sensitive)
 {
-    if(!size_) pBlocks = nullptr;
-    else {
-        pBlocks = new BYTE [size_];
-        memset(pBlocks, init_value, size_);
-    }
+    allocate(size_);
+    if(size_) memset(pBlocks, init_value, size_);
 }
-ByteBlock::ByteBlock(BYTE * pBlocks_, size_t size_) :
-    amount_of_bytes(size_)
+ByteBlock::ByteBlock(const BYTE * pBlocks_, size_t size_) :
+    aligned_body(false), sensitivity_tag(Sensitivity::sensitive)
 {
-    pBlocks = new BYTE [size_];
-    memcpy(pBlocks, pBlocks_, size_);
+    allocate(size_);
+    if(size_) memcpy(pBlocks, pBlocks_, size_);
+    ByteStats::on_copy(size_);
 }
-ByteBlock::ByteBlock(ByteBlock && rhs) :
-    pBlocks(rhs.pBlocks), amount_of_bytes(rhs.amount_of_bytes)
+ByteBlock::ByteBlock(ByteView view) :
+    ByteBlock(view.byte_ptr(), view.size())
 {
-    rhs.pBlocks = nullptr;
-    rhs.amount_of_bytes = 0;
+    // nothing
+}
+ByteBlock::ByteBlock(ByteBlock && rhs) {
+    steal(rhs);
 }
 ByteBlock::~ByteBlock() {
-    if(pBlocks) {
-        memset(pBlocks, 0, amount_of_bytes);
-        delete [] pBlocks;
-    }
+    release();
+}
+
+ByteBlock ByteBlock::cache_aligned(size_t size_, BYTE init_value) {
+    ByteBlock tmp;
+    tmp.aligned_body = true;
+    tmp.allocate(size_);
+    if(size_) memset(tmp.pBlocks, init_value, size_);
+    return tmp;
 }
 
 void ByteBlock::operator = (ByteBlock && rhs) {
     if(this == &rhs) return;
+    release();
+    steal(rhs);
+}
+
+void ByteBlock::allocate(size_t size_) {
+    amount_of_bytes = size_;
+    if(!size_) {
+        pBlocks = nullptr;
+        reserved_bytes = 0;
+    } else if(size_ <= inline_capacity && !aligned_body) {
+        pBlocks = inline_storage;
+        reserved_bytes = inline_capacity;
+    } else {
+        pBlocks = BytePool::acquire(size_);
+        reserved_bytes = BytePool::capacity_for(size_);
+        ByteStats::on_allocate(reserved_bytes);
+    }
+}
+
+void ByteBlock::release() {
     if(pBlocks) {
-        memset(pBlocks, 0, amount_of_bytes);
-        delete [] pBlocks;
+        wipe(pBlocks, amount_of_bytes);
+        if(pBlocks != inline_storage) {
+            BytePool::recycle(pBlocks, reserved_bytes);
+            ByteStats::on_release(reserved_bytes);
+        }
     }
-    pBlocks = rhs.pBlocks;
+    pBlocks = nullptr;
+    amount_of_bytes = 0;
+    reserved_bytes = 0;
+}
+
+void ByteBlock::steal(ByteBlock & rhs) {
     amount_of_bytes = rhs.amount_of_bytes;
+    reserved_bytes = rhs.reserved_bytes;
+    aligned_body = rhs.aligned_body;
+    sensitivity_tag = rhs.sensitivity_tag;
+    if(rhs.pBlocks == rhs.inline_storage) {
+        pBlocks = inline_storage;
+        memcpy(inline_storage, rhs.inline_storage, amount_of_bytes);
+        rhs.wipe(rhs.inline_storage, amount_of_bytes);
+    } else {
+        pBlocks = rhs.pBlocks;
+    }
     rhs.pBlocks = nullptr;
     rhs.amount_of_bytes = 0;
+    rhs.reserved_bytes = 0;
+}
+
+void ByteBlock::wipe(BYTE * ptr, size_t n_bytes) const {
+    if(!n_bytes) return;
+    if( sensitivity_tag == Sensitivity::sensitive ||
+        global_wipe_policy.load(std::memory_order_relaxed) == WipePolicy::everything )
+    {
+        raw_bytes::secure_zero(ptr, n_bytes);
+        ByteStats::on_wipe(n_bytes);
+    }
 }
 
 BYTE * ByteBlock::byte_ptr() {
@@ -76,138 +187,290 @@ bool ByteBlock::operator != (const ByteBlock & lhs) const {
 }
 
 void ByteBlock::reset(const BYTE * pBlocks_, size_t size_) {
-    if(pBlocks) {
-        memset(pBlocks, 0, amount_of_bytes);
-        delete [] pBlocks;
+    if(!size_) {
+        release();
+        return;
     }
 
-    if( !size_ ) {
-        pBlocks = nullptr;
-        amount_of_bytes = 0;
+    if(size_ > reserved_bytes) {
+        ByteBlock tmp;
+        tmp.aligned_body = aligned_body;
+        tmp.sensitivity_tag = sensitivity_tag;
+        tmp.allocate(size_);
+        if( pBlocks_ ) memcpy(tmp.pBlocks, pBlocks_, size_);
+        else memset(tmp.pBlocks, 0, size_);
+        *this = std::move(tmp);
         return;
     }
 
-    pBlocks = new BYTE [size_];
-    amount_of_bytes = size_;
-
-    if( pBlocks_ ) memcpy(pBlocks, pBlocks_, size_);
+    if( pBlocks_ ) memmove(pBlocks, pBlocks_, size_);
     else memset(pBlocks, 0, size_);
+    if(size_ < amount_of_bytes) wipe(pBlocks + size_, amount_of_bytes - size_);
+    amount_of_bytes = size_;
 }
 
 size_t ByteBlock::size() const {
     return amount_of_bytes;
 };
 
-ByteBlock ByteBlock::deep_copy() const {
-    return ByteBlock(pBlocks, amount_of_bytes);
+size_t ByteBlock::capacity() const {
+    return reserved_bytes;
 }
 
-ByteBlock ByteBlock::operator () (size_t begin, size_t length) const {
+void ByteBlock::reserve(size_t capacity_) {
+    if(capacity_ <= reserved_bytes) return;
+
     ByteBlock tmp;
-    tmp.reset(pBlocks + begin, length);
+    tmp.aligned_body = aligned_body;
+    tmp.sensitivity_tag = sensitivity_tag;
+    tmp.allocate(capacity_);
+    tmp.amount_of_bytes = amount_of_bytes;
+    if(amount_of_bytes) memcpy(tmp.pBlocks, pBlocks, amount_of_bytes);
+    *this = std::move(tmp);
+}
+
+void ByteBlock::resize(size_t size_) {
+    if(size_ == amount_of_bytes) return;
+    reserve(size_);
+    if(size_ > amount_of_bytes)
+        memset(pBlocks + amount_of_bytes, 0, size_ - amount_of_bytes);
+    else
+        wipe(pBlocks + size_, amount_of_bytes - size_);
+    amount_of_bytes = size_;
+}
+
+bool ByteBlock::is_cache_aligned() const {
+    return aligned_body;
+}
+
+void ByteBlock::set_sensitivity(Sensitivity tag) {
+    sensitivity_tag = tag;
+}
+
+Sensitivity ByteBlock::sensitivity() const {
+    return sensitivity_tag;
+}
+
+void ByteBlock::set_wipe_policy(WipePolicy policy) {
+    global_wipe_policy = policy;
+}
+
+WipePolicy ByteBlock::wipe_policy() {
+    return global_wipe_policy;
+}
+
+ByteBlock ByteBlock::deep_copy() const {
+    ByteBlock tmp(pBlocks, amount_of_bytes);
+    tmp.sensitivity_tag = sensitivity_tag;
     return tmp;
 }
 
+ByteView ByteBlock::operator () (size_t begin, size_t length) const {
+    return ByteView(pBlocks + begin, length);
+}
+
 void swap(ByteBlock & lhs, ByteBlock & rhs) {
-    BYTE * p = lhs.pBlocks;
-    size_t s = lhs.amount_of_bytes;
-    lhs.pBlocks = rhs.pBlocks;
-    lhs.amount_of_bytes = rhs.amount_of_bytes;
-    rhs.pBlocks = p;
-    rhs.amount_of_bytes = s;
+    if(&lhs == &rhs) return;
+    ByteBlock tmp;
+    tmp.steal(lhs);
+    lhs.steal(rhs);
+    rhs.steal(tmp);
 }
 
-bool equal(ByteBlock const & lhs, ByteBlock const & rhs) {
-    auto size = lhs.amount_of_bytes;
-    if (size != rhs.amount_of_bytes)
+bool equal(ByteView lhs, ByteView rhs) {
+    auto size = lhs.size();
+    if (size != rhs.size())
         return false;
-    for (unsigned i = 0; i < size; i++) if(lhs.pBlocks[i] != rhs.pBlocks[i])
+    for (unsigned i = 0; i < size; i++) if(lhs[i] != rhs[i])
         return false;
 
     return true;
 }
 
+bool overlap(ByteView lhs, ByteView rhs) {
+    if(!lhs.size() || !rhs.size()) return false;
+    return lhs.byte_ptr() < rhs.byte_ptr() + rhs.size() &&
+           rhs.byte_ptr() < lhs.byte_ptr() + lhs.size();
+}
 
-vector<ByteBlock> split_blocks(const ByteBlock & src, size_t length) {
+vector<ByteBlock> split_blocks(ByteView src, size_t length) {
     vector<ByteBlock> tmp;
     size_t amount = src.size() / length;
     size_t tail = src.size() % length;
+    tmp.reserve(amount + (tail ? 1 : 0));
     for(int i = 0; i < amount; i++)
-        tmp.push_back(src(i * length, length));
+        tmp.push_back(src(i * length, length).deep_copy());
     if(tail)
-        tmp.push_back(src(amount * length, tail));
+        tmp.push_back(src(amount * length, tail).deep_copy());
 
     return tmp;
 }
 
 ByteBlock join_blocks(const vector<ByteBlock> & blocks) {
-    if(blocks.empty()) return ByteBlock();
+    ByteBlock tmp;
+    join_blocks(blocks, tmp);
+    return tmp;
+}
+
+void join_blocks(const vector<ByteBlock> & blocks, ByteBlock & dst) {
+    if(blocks.empty()) {
+        dst.reset(nullptr, 0);
+        return;
+    }
 
     size_t size_vector = blocks.size();
     size_t size_block = blocks[0].size();
     size_t size_last = blocks[size_vector - 1].size();
     size_t size_byteblock = (size_vector - 1) * size_block + size_last;
 
-    ByteBlock tmp(size_byteblock);
+    dst.resize(size_byteblock);
     for(int i = 0; i < size_vector - 1; i++) {
         memcpy(
-            tmp.byte_ptr() + i * size_block,
+            dst.byte_ptr() + i * size_block,
             blocks[i].byte_ptr(),
             size_block
         );
     }
     memcpy(
-        tmp.byte_ptr() + (size_vector - 1) * size_block,
+        dst.byte_ptr() + (size_vector - 1) * size_block,
         blocks[size_vector - 1].byte_ptr(),
         size_last
     );
-
-    return tmp;
 }
 
-void xor_blocks(ByteBlock & to_assign, const ByteBlock & lhs, const ByteBlock & rhs) {
+void xor_blocks(ByteBlock & to_assign, ByteView lhs, ByteView rhs) {
     size_t result_size = lhs.size() > rhs.size() ? rhs.size() : lhs.size();
-    ByteBlock tmp(result_size);
-    for(size_t i = 0; i < result_size; i++)
-        tmp[i] = lhs[i] ^ rhs[i];
-    to_assign = std::move(tmp);
-}
-
-inline char to_hex_literal(BYTE number) {
-    if(number < 10) return '0' + number;
-    if(number < 16) return 'a' + number - 10;
-    throw std::invalid_argument("to_hex_literal: " + std::to_string(number));
-}
-inline BYTE from_hex_literal(char symbol) {
-    if(isdigit(symbol)) return symbol - '0';
-    if(symbol >= 'a' && symbol <= 'f') return symbol - 'a' + 10;
-    if(symbol >= 'A' && symbol <= 'F') return symbol - 'A' + 10;
-    throw std::invalid_argument("from_hex_literal: " + std::to_string(symbol));
-}
-string hex_representation(const ByteBlock & bb) {
-    stringstream ss;
-    for(int i = 0; i < bb.size(); i++) {
-        ss << to_hex_literal(bb[i] >> 4);
-        ss << to_hex_literal(bb[i] & 0xF);
+
+    if(rhs.byte_ptr() == to_assign.byte_ptr()) std::swap(lhs, rhs);
+    bool rhs_apart = !overlap(rhs, to_assign) || rhs.byte_ptr() == lhs.byte_ptr();
+
+    if(lhs.byte_ptr() == to_assign.byte_ptr() && rhs_apart) {
+        // the result takes place of lhs, nothing to allocate
+        raw_bytes::xor_inplace(to_assign.byte_ptr(), rhs.byte_ptr(), result_size);
+        to_assign.resize(result_size);
+    } else if(!overlap(lhs, to_assign) && !overlap(rhs, to_assign)) {
+        to_assign.reset(lhs.byte_ptr(), result_size);
+        raw_bytes::xor_inplace(to_assign.byte_ptr(), rhs.byte_ptr(), result_size);
+    } else {
+        ByteBlock tmp(result_size);
+        tmp.set_sensitivity(to_assign.sensitivity());
+        raw_bytes::xor_n(tmp.byte_ptr(), lhs.byte_ptr(), rhs.byte_ptr(), result_size);
+        to_assign = std::move(tmp);
     }
-    string result;
-    getline(ss, result);
-    return result;
 }
 
-ByteBlock hex_to_bytes(char const * s, unsigned length)
+BYTE * prepare_output(ByteView & src, ByteBlock & dst, ByteBlock & holder) {
+    if(src.byte_ptr() != dst.byte_ptr() && overlap(src, dst)) {
+        holder = src.deep_copy();
+        src = holder;
+    }
+    dst.resize(src.size());
+    return dst.byte_ptr();
+}
+
+SegmentReader::SegmentReader(const ByteView * segments_, size_t n_segments_) :
+    segments(segments_), n_segments(n_segments_),
+    index(0), segment_start(0), position(0), total(0)
+{
+    for(size_t i = 0; i < n_segments; i++)
+        total += segments[i].size();
+    // step over empty segments at the beginning
+    seek(0);
+}
+
+SegmentReader::SegmentReader(const vector<ByteView> & segments_) :
+    SegmentReader(segments_.data(), segments_.size())
 {
-    if(length % 2) throw std::invalid_argument("length of hex-string must be even number");
-    size_t size = length / 2;
+    // nothing
+}
+
+size_t SegmentReader::size() const {
+    return total;
+}
+
+size_t SegmentReader::remaining() const {
+    return total - position;
+}
 
-    ByteBlock result(size);
-    for(int i = 0; i < size; i++) {
-        result[i] = from_hex_literal(s[2 * i]) << 4;
-        result[i] += from_hex_literal(s[2 * i + 1]);
+void SegmentReader::seek(size_t position_) {
+    if(position_ > total)
+        throw std::out_of_range("SegmentReader: position is past the end");
+    while(position_ < segment_start) {
+        index--;
+        segment_start -= segments[index].size();
+    }
+    while(index < n_segments && position_ >= segment_start + segments[index].size()) {
+        segment_start += segments[index].size();
+        index++;
     }
+    position = position_;
+}
+
+const BYTE * SegmentReader::read(size_t n_bytes, BYTE * buffer) {
+    if(n_bytes > remaining())
+        throw std::length_error("SegmentReader: not enough bytes left");
+    if(!n_bytes) return buffer;
+
+    const BYTE * result;
+    size_t offset = position - segment_start;
+    if(offset + n_bytes <= segments[index].size()) {
+        result = segments[index].byte_ptr() + offset;
+    } else {
+        size_t copied = 0;
+        for(size_t i = index; copied < n_bytes; i++, offset = 0) {
+            size_t length = std::min(n_bytes - copied, segments[i].size() - offset);
+            memcpy(buffer + copied, segments[i].byte_ptr() + offset, length);
+            copied += length;
+        }
+        result = buffer;
+    }
+    seek(position + n_bytes);
     return result;
 }
 
-ByteBlock hex_to_bytes(const string & s) {
-    return hex_to_bytes(s.c_str(), s.size());
+SegmentWriter::SegmentWriter(const MutableByteView * segments_, size_t n_segments_) :
+    segments(segments_), n_segments(n_segments_), index(0), offset(0), left(0)
+{
+    for(size_t i = 0; i < n_segments; i++)
+        left += segments[i].size();
+}
+
+SegmentWriter::SegmentWriter(const vector<MutableByteView> & segments_) :
+    SegmentWriter(segments_.data(), segments_.size())
+{
+    // nothing
+}
+
+size_t SegmentWriter::remaining() const {
+    return left;
+}
+
+BYTE * SegmentWriter::peek(size_t n_bytes, BYTE * buffer) {
+    while(index < n_segments && offset == segments[index].size()) {
+        index++;
+        offset = 0;
+    }
+    if(index < n_segments && offset + n_bytes <= segments[index].size())
+        return segments[index].byte_ptr() + offset;
+    return buffer;
+}
+
+void SegmentWriter::write(const BYTE * data, size_t n_bytes) {
+    if(n_bytes > left)
+        throw std::length_error("SegmentWriter: not enough room left");
+
+    left -= n_bytes;
+    while(n_bytes) {
+        if(offset == segments[index].size()) {
+            index++;
+            offset = 0;
+            continue;
+        }
+        size_t length = std::min(n_bytes, segments[index].size() - offset);
+        BYTE * target = segments[index].byte_ptr() + offset;
+        if(target != data) memcpy(target, data, length);
+        data += length;
+        offset += length;
+        n_bytes -= length;
+    }
 }
@@ -4,16 +4,104 @@ using std::make_tuple;
 using std::pair;
 using std::make_pair;
 
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 #include <MyCryptoLib/rawbytes.hpp>
+#include <MyCryptoLib/useful.hpp>
 using namespace raw_bytes;
 
+// ----------------------------- xor kernels ---------------------------------
+
+static void xor_words(byte * dst, const byte * lhs, const byte * rhs, size_t n_bytes) {
+    size_t i = 0;
+    for(; i + sizeof(qword) <= n_bytes; i += sizeof(qword)) {
+        qword a, b;
+        memcpy(&a, lhs + i, sizeof a);
+        memcpy(&b, rhs + i, sizeof b);
+        a ^= b;
+        memcpy(dst + i, &a, sizeof a);
+    }
+    for(; i < n_bytes; i++) dst[i] = lhs[i] ^ rhs[i];
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("sse2")))
+static void xor_sse2(byte * dst, const byte * lhs, const byte * rhs, size_t n_bytes) {
+    size_t i = 0;
+    for(; i + 16 <= n_bytes; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_xor_si128(a, b));
+    }
+    xor_words(dst + i, lhs + i, rhs + i, n_bytes - i);
+}
+
+__attribute__((target("avx2")))
+static void xor_avx2(byte * dst, const byte * lhs, const byte * rhs, size_t n_bytes) {
+    size_t i = 0;
+    for(; i + 32 <= n_bytes; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_xor_si256(a, b));
+    }
+    xor_sse2(dst + i, lhs + i, rhs + i, n_bytes - i);
+}
+
+typedef void (*xor_kernel)(byte *, const byte *, const byte *, size_t);
+
+static xor_kernel choose_xor_kernel() {
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) return xor_avx2;
+#if defined(__SSE2__)
+    return xor_sse2;
+#else
+    if(__builtin_cpu_supports("sse2")) return xor_sse2;
+    return xor_words;
+#endif
+}
+
 void raw_bytes::xor_n( byte * dst,
             const byte * lhs,
             const byte * rhs,
-            unsigned int n_bytes )
+            size_t n_bytes )
 {
-	const byte * p_end = dst + n_bytes;
-	while(dst != p_end) *(dst++) = *(lhs++) ^ *(rhs++);
+    // a cipher block isn't worth a call through the pointer
+    if(n_bytes <= 16) {
+        xor_words(dst, lhs, rhs, n_bytes);
+        return;
+    }
+    static const xor_kernel kernel = choose_xor_kernel();
+    kernel(dst, lhs, rhs, n_bytes);
+}
+
+#else
+
+void raw_bytes::xor_n( byte * dst,
+            const byte * lhs,
+            const byte * rhs,
+            size_t n_bytes )
+{
+    xor_words(dst, lhs, rhs, n_bytes);
+}
+
+#endif
+
+void raw_bytes::xor_inplace(byte * dst, const byte * src, size_t n_bytes) {
+    xor_n(dst, dst, src, n_bytes);
+}
+
+// ---------------------------------------------------------------------------
+
+void raw_bytes::secure_zero(byte * dst, size_t n_bytes) {
+    if(!n_bytes) return;
+    memset(dst, 0, n_bytes);
+    // the compiler has to assume dst is read here
+    __asm__ __volatile__("" : : "r"(dst) : "memory");
 }
 
 short raw_bytes::nonzero_msb(word number) {
@@ -60,6 +148,8 @@ std::tuple<word, word, word> raw_bytes::ext_gcd_poly(word a, word b) {
 
 byte raw_bytes::inverse_poly(byte a, word modulus) {
     if(a == 0) return 0;
+    if(modulus == 0x11B) return GaloisField<0x11B>::inverse(a);
+    if(modulus == 0x1C3) return GaloisField<0x1C3>::inverse(a);
     return std::get<1>(ext_gcd_poly(a, modulus));
 }
 
@@ -77,15 +167,84 @@ short raw_bytes::scalar_product(word lhs, word rhs) {
 	return sum_of_bits(lhs & rhs) & 0x1;
 }
 
+// ---------------------------- field tables ---------------------------------
+
+static constexpr unsigned field_double(unsigned x, unsigned modulus) {
+    return ((x << 1) ^ (x & 0x80 ? modulus : 0)) & 0xff;
+}
+static constexpr unsigned field_multiply(unsigned lhs, unsigned rhs, unsigned modulus) {
+    return rhs ?
+        ((rhs & 1 ? lhs : 0) ^ field_multiply(field_double(lhs, modulus), rhs >> 1, modulus)) : 0;
+}
+static constexpr unsigned field_power(unsigned base, unsigned p, unsigned modulus) {
+    return p ? field_multiply(p & 1 ? base : 1,
+                              field_power(field_multiply(base, base, modulus), p >> 1, modulus),
+                              modulus) : 1;
+}
+
+// Order of g is a divisor of 255, it generates the group unless
+// it falls on 1 at 255 / 3, 255 / 5 or 255 / 17
+static constexpr bool is_generator(unsigned g, unsigned modulus) {
+    return field_power(g, 85, modulus) != 1 &&
+           field_power(g, 51, modulus) != 1 &&
+           field_power(g, 15, modulus) != 1;
+}
+static constexpr unsigned least_generator(unsigned modulus, unsigned g = 2) {
+    return is_generator(g, modulus) ? g : least_generator(modulus, g + 1);
+}
+
+// k such that g^k = x, found by walking powers from g^from
+static constexpr unsigned field_log(unsigned x, unsigned g, unsigned modulus,
+                                    unsigned from = 0, unsigned power = 1) {
+    return power == x || from == 255 ? from :
+        field_log(x, g, modulus, from + 1, field_multiply(power, g, modulus));
+}
+
+template <size_t... I>
+static constexpr FieldTables::Products make_products(unsigned lhs, unsigned modulus, Indices<I...>) {
+    return FieldTables::Products {{ byte(field_multiply(lhs, I, modulus))... }};
+}
+
+// Products are made a row at a time, a pack of 65536 would take
+// the compiler far longer
+template <size_t... I, size_t... J>
+static constexpr FieldTables make_field_tables(unsigned modulus, unsigned g,
+    Indices<I...>, Indices<J...> bytes)
+{
+    return FieldTables {
+        { byte(field_power(g, I % 255, modulus))... },
+        { byte(J ? field_log(J, g, modulus) : 0)... },
+        { make_products(J, modulus, bytes)... }
+    };
+}
+
+#define FIELD_TABLES(modulus) make_field_tables( \
+    (modulus), least_generator(modulus), \
+    MakeIndices<512>::type(), MakeIndices<256>::type())
+
+template <> const FieldTables GaloisField<0x11B>::tables = FIELD_TABLES(0x11B);
+template <> const FieldTables GaloisField<0x1C3>::tables = FIELD_TABLES(0x1C3);
+
+#undef FIELD_TABLES
+
 word raw_bytes::multiply_field(word lhs, word rhs, word modulus) {
+    if(lhs < 0x100 && rhs < 0x100) {
+        if(modulus == 0x11B) return GaloisField<0x11B>::multiply(lhs, rhs);
+        if(modulus == 0x1C3) return GaloisField<0x1C3>::multiply(lhs, rhs);
+    }
     word product = multiply_poly(lhs, rhs);
     return std::get<1>(divide_poly(product, modulus));
 }
 
 word raw_bytes::power_field(word base, word p, word modulus) {
-    if(p == 0) return 1;
-    word result = base;
-    for(int i = 0; i < p - 1; i++)
-        result = multiply_field(result, base, modulus);
+    if(modulus == 0x11B) return GaloisField<0x11B>::power(base, p);
+    if(modulus == 0x1C3) return GaloisField<0x1C3>::power(base, p);
+
+    // squares of base for bits of p
+    word result = 1;
+    for(; p; p >>= 1) {
+        if(p & 1) result = multiply_field(result, base, modulus);
+        base = multiply_field(base, base, modulus);
+    }
     return result;
 }
@@ -1,5 +1,4 @@
 #include <cstring>
-#include <machine/endian.h>
 #include <iostream>
 using std::cerr; using std::endl;
 
@@ -43,7 +42,7 @@ static uint32_t const init_h[] =
 };
 
 // ============================= Functions ================================== //
-void hash_function(byte * dst, byte const * msg, unsigned msg_len);
+void hash_function(byte * dst, SegmentReader & msg);
 //void round_function(byte *, byte *, byte const *);
 void round_function(uint32_t const * msg_block, uint32_t * prev_h);
 // ---------------- Round Function Transformations -------------------------- //
@@ -60,30 +59,42 @@ uint32_t rotl32(uint32_t x, unsigned short n = 1);
 // ========================================================================== //
 
 // ======================= SHA256 Hash Function ============================ //
-void SHA256::hash(ByteBlock const & src, ByteBlock & dst) const
+void SHA256::hash(ByteView src, ByteBlock & dst) const
 {
-    dst = ByteBlock(_hash_length);
-    hash_function(dst.byte_ptr(), src.byte_ptr(), src.size());
+    SegmentReader message(&src, 1);
+    hash(message, dst);
+}
+
+void SHA256::hash(SegmentReader & src, ByteBlock & dst) const
+{
+    byte hash_output [_hash_length];
+    hash_function(hash_output, src);
+    dst.reset(hash_output, _hash_length);
 }
 
 // ============================== Realization =============================== //
-void hash_function(byte * dst, byte const * msg, unsigned msg_len)
+void hash_function(byte * dst, SegmentReader & msg)
 {
     uint32_t hash[8];
     for (int i = 0; i < 8; i++)
         hash[i] = init_h[i];
 
+    unsigned msg_len         = msg.remaining();
     unsigned integral_parts  = msg_len >> 6;                     // msg_len / 64
     unsigned tail_part_len   = msg_len - (integral_parts << 6);  // integral_parts * 64
 
-    auto msg_block = reinterpret_cast<uint32_t const *>(msg);
-    for (int i = 0; i < integral_parts; i++, msg_block += 16)
-        round_function(msg_block, hash);
+    // blocks which span segments are gathered here
+    byte msg_buffer[64];
+    for (int i = 0; i < integral_parts; i++)
+        round_function(
+            reinterpret_cast<uint32_t const *>(msg.read(64, msg_buffer)),
+            hash
+        );
 
     byte padded_msg[128] = { 0 };
-    msg += integral_parts << 6;
-    for (int i = 0 ; i < tail_part_len; i++)
-        padded_msg[i] = msg[i];
+    byte const * tail = msg.read(tail_part_len, padded_msg);
+    if (tail != padded_msg)
+        memcpy(padded_msg, tail, tail_part_len);
 
     unsigned shift = 0;
     if (tail_part_len > 64 - 9) {
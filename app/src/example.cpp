@@ -23,6 +23,8 @@ using namespace CommandLineProcessing;
 #include <MyCryptoLib/Kuznyechik.hpp>
 #include <MyCryptoLib/Rijndael.hpp>
 #include <MyCryptoLib/mycrypto.hpp>
+#include <MyCryptoLib/bytestats.hpp>
+#include <MyCryptoLib/bytepool.hpp>
 
 vector<string> split(const string & s, char ch) {
     vector<string> v;
@@ -58,6 +60,19 @@ vector<string> read_cipher_params(const string & filename) {
 	return result;
 }
 
+void print_statistics() {
+	ByteCounters counters = ByteStats::global();
+	BytePoolStats pool = BytePool::statistics();
+	cerr << "allocations:     " << counters.allocations
+		 << " (" << counters.bytes_allocated << " bytes)" << endl;
+	cerr << "deep copies:     " << counters.deep_copies
+		 << " (" << counters.bytes_copied << " bytes)" << endl;
+	cerr << "wipes:           " << counters.wipes
+		 << " (" << counters.bytes_wiped << " bytes)" << endl;
+	cerr << "peak live bytes: " << counters.peak_live_bytes << endl;
+	cerr << "pool hits:       " << pool.hits << ", misses: " << pool.misses << endl;
+}
+
 bool logic_xor3(bool x, bool y, bool z) {
     return (!x && !y && z) || (!x && y && !z) || (x && !y && !z);
 }
@@ -77,6 +92,7 @@ int main(int argc, char ** argv) {
 		cmd.defineOption("decrypt", "Decrypt the message");
 
         cmd.defineOption("parallel-decrypt", "Decrypt the message with parallelizm");
+		cmd.defineOption("stats", "Print allocation, copy and wipe counters of the run (so does MYCRYPTO_ACCOUNTING=1)");
 
 		cmd.defineOptionAlternative("path", "P");
 		cmd.defineOptionAlternative("dest", "D");
@@ -109,10 +125,18 @@ int main(int argc, char ** argv) {
             );
         }
 
+		if(cmd.foundOption("stats")) {
+			ByteStats::set_enabled(true);
+			ByteStats::reset();
+		}
+
 		auto cipher_params = read_cipher_params(src_filename);
 		ByteBlock key = hex_to_bytes(cipher_params[0]);
 		ByteBlock iv = hex_to_bytes(cipher_params[1]);
-		ByteBlock message = hex_to_bytes(cipher_params[2]);
+		// plaintext to encrypt is wiped, ciphertext to decrypt isn't
+		Sensitivity input_tag = cmd.foundOption("encrypt") ?
+			Sensitivity::sensitive : Sensitivity::nonsensitive;
+		ByteBlock message = hex_to_bytes(cipher_params[2], input_tag);
 		ByteBlock output;
 
 		CFB_Mode<Kuznyechik> encryptor(Kuznyechik(key), iv);
@@ -136,6 +160,8 @@ int main(int argc, char ** argv) {
 		fout << "INPUT=" << cipher_params[2] << endl;
 		fout << "OUTPUT=" << hex_representation(output) << endl;
 		fout.close();
+
+		if(ByteStats::enabled()) print_statistics();
 	} catch(const std::exception & e) {
 		cerr << "Error: " << e.what() << endl;
 		cerr << "For help type: " << endl << argv[0] << " --help" << endl;
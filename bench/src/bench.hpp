@@ -0,0 +1,41 @@
+#include <functional>
+#include <string>
+#include <cstdint>
+
+#ifndef __BENCH__
+#define __BENCH__
+
+// Calls f over and over for at least min_seconds,
+// returns the number of calls per second
+double calls_per_second(const std::function<void()> & f, double min_seconds = 0.3);
+
+// Print one line of a report: what was measured and how fast
+void report(const std::string & name, double value, const std::string & unit);
+
+// Time stamp counter where there is one, nanoseconds elsewhere
+uint64_t cycles();
+
+// Hardware event counter of the calling thread, user space only.
+// read() gives -1 when the kernel or the machine doesn't count it
+class EventCounter {
+    int fd;
+public:
+    enum Event { cache_misses, l1d_misses };
+
+    explicit EventCounter(Event event);
+    ~EventCounter();
+    EventCounter(const EventCounter &) = delete;
+    EventCounter & operator = (const EventCounter &) = delete;
+
+    bool available() const { return fd >= 0; }
+    void start();
+    void stop();
+    long long read() const;
+};
+
+// Benchmarks, each prints its own lines
+void bench_key_setup();
+void bench_footprint();
+void bench_ciphers();
+
+#endif
@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <vector>
+
+#include <MyCryptoLib/Kuznyechik.hpp>
+#include <MyCryptoLib/Rijndael.hpp>
+
+#include "bench.hpp"
+
+// Best of a few runs over messages of n_blocks, in cycles per byte
+template <typename Crypt>
+static double cycles_per_byte(Crypt crypt, size_t n_blocks, int rounds) {
+    std::vector<uint8_t> message(16 * n_blocks, 0x5a);
+    double best = 1e300;
+    for(int trial = 0; trial < 5; trial++) {
+        uint64_t start = cycles();
+        for(int r = 0; r < rounds; r++)
+            crypt(message.data(), n_blocks);
+        double spent = double(cycles() - start) / (16.0 * n_blocks * rounds);
+        if(spent < best) best = spent;
+    }
+    return best;
+}
+
+// Single blocks through encrypt_block(), then 16 KB through encrypt_blocks()
+// and decrypt_blocks()
+template <typename Cipher>
+static void run(const std::string & name, const Cipher & cipher) {
+    uint8_t block[16] = {};
+    printf("%-28s %8.2f %8.2f %8.2f\n", name.c_str(),
+        cycles_per_byte([&](uint8_t *, size_t) { cipher.encrypt_block(block, block); }, 1, 20000),
+        cycles_per_byte([&](uint8_t * p, size_t n) { cipher.encrypt_blocks(p, p, n); }, 1024, 20),
+        cycles_per_byte([&](uint8_t * p, size_t n) { cipher.decrypt_blocks(p, p, n); }, 1024, 20));
+}
+
+void bench_ciphers() {
+    ByteBlock key(32);
+    for(size_t i = 0; i < key.size(); i++) key[i] = i;
+
+    printf("%-28s %8s %8s %8s  (cycles/B)\n", "cipher", "block", "encrypt", "decrypt");
+    run("AES128 tables", AES128(key(0, 16), AesEngine::tables));
+    run("AES192 tables", AES192(key(0, 24), AesEngine::tables));
+    run("AES256 tables", AES256(key, AesEngine::tables));
+    run("AES128 aesni", AES128(key(0, 16), AesEngine::aesni));
+    run("AES192 aesni", AES192(key(0, 24), AesEngine::aesni));
+    run("AES256 aesni", AES256(key, AesEngine::aesni));
+    run("AES128 bitsliced", AES128(key(0, 16), AesEngine::bitsliced));
+    run("AES192 bitsliced", AES192(key(0, 24), AesEngine::bitsliced));
+    run("AES256 bitsliced", AES256(key, AesEngine::bitsliced));
+    run("Kuznyechik lookup", Kuznyechik(key, Kuznyechik::Engine::lookup));
+    run("Kuznyechik compact", Kuznyechik(key, Kuznyechik::Engine::compact));
+    run("Kuznyechik simd", Kuznyechik(key, Kuznyechik::Engine::simd));
+    run("Kuznyechik constant_time", Kuznyechik(key, Kuznyechik::Engine::constant_time));
+}
@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <vector>
+
+#include <MyCryptoLib/Kuznyechik.hpp>
+
+#include "bench.hpp"
+
+// Engines with tables of different size, Kuznyechik::Engine order
+static const char * ENGINE_NAMES[] = {
+    "reference", "lookup", "compact", "simd", "constant_time"
+};
+
+struct Measure {
+    double cycles_per_byte;
+    double l1d_misses_per_block;
+    double cache_misses_per_block;
+};
+
+// Encrypt messages of n_blocks, touching neighbour bytes of other memory
+// before each of them like other tenants of the core would. Only the
+// cipher is timed and counted, the best of a few trials is taken
+static Measure run(const Kuznyechik & cipher, size_t n_blocks, size_t neighbour, int rounds) {
+    std::vector<uint8_t> message(16 * n_blocks, 0x5a), other(neighbour, 1);
+    EventCounter l1d(EventCounter::l1d_misses), llc(EventCounter::cache_misses);
+    const double blocks = double(n_blocks) * rounds;
+
+    Measure best = { 1e300, -1, -1 };
+    for(int trial = 0; trial < 5; trial++) {
+        uint64_t spent = 0;
+        long long l1d_total = 0, llc_total = 0;
+        for(int r = 0; r < rounds; r++) {
+            for(size_t i = 0; i < neighbour; i += 64) other[i]++;
+            l1d.start();
+            llc.start();
+            uint64_t start = cycles();
+            cipher.encrypt_blocks(message.data(), message.data(), n_blocks);
+            spent += cycles() - start;
+            l1d.stop();
+            llc.stop();
+            l1d_total += l1d.read();
+            llc_total += llc.read();
+        }
+        if(spent / (16 * blocks) < best.cycles_per_byte) {
+            best.cycles_per_byte = spent / (16 * blocks);
+            if(l1d.available()) best.l1d_misses_per_block = l1d_total / blocks;
+            if(llc.available()) best.cache_misses_per_block = llc_total / blocks;
+        }
+    }
+    return best;
+}
+
+static void print(const char * engine, const char * load, const Measure & m) {
+    printf("Kuznyechik %-14s %-22s %8.2f cycles/B", engine, load, m.cycles_per_byte);
+    if(m.l1d_misses_per_block >= 0)
+        printf("  %7.2f L1d misses/block  %7.3f cache misses/block",
+               m.l1d_misses_per_block, m.cache_misses_per_block);
+    else
+        printf("  (cache counters unavailable)");
+    printf("\n");
+}
+
+// Bulk messages on a quiet core, then short ones between bursts of
+// neighbours which sweep 48 KB, more than L1 holds, and 2 MB, more than L2
+void bench_footprint() {
+    ByteBlock key(32);
+    for(size_t i = 0; i < key.size(); i++) key[i] = i;
+
+    for(int e = 1; e < 5; e++) {
+        Kuznyechik::Engine engine = static_cast<Kuznyechik::Engine>(e);
+        Kuznyechik cipher(key, engine);
+        print(ENGINE_NAMES[e], "64 KB messages", run(cipher, 4096, 0, 20));
+        print(ENGINE_NAMES[e], "64 B, 48 KB neighbour", run(cipher, 4, 48 * 1024, 2000));
+        print(ENGINE_NAMES[e], "64 B, 2 MB neighbour", run(cipher, 4, 2048 * 1024, 200));
+    }
+}
@@ -0,0 +1,60 @@
+#include <MyCryptoLib/Kuznyechik.hpp>
+#include <MyCryptoLib/Rijndael.hpp>
+
+#include "bench.hpp"
+
+static const char * aes_engine_name(AesEngine engine) {
+    switch(engine) {
+    case AesEngine::tables: return "tables";
+    case AesEngine::aesni: return "aesni";
+    default: return "bitsliced";
+    }
+}
+
+static const char * engine_name(Kuznyechik::Engine engine) {
+    switch(engine) {
+    case Kuznyechik::Engine::reference: return "reference";
+    case Kuznyechik::Engine::lookup: return "lookup";
+    case Kuznyechik::Engine::simd: return "simd";
+    default: return "constant_time";
+    }
+}
+
+void bench_key_setup() {
+    const Kuznyechik::Engine engines[] = {
+        Kuznyechik::Engine::reference,
+        Kuznyechik::Engine::lookup,
+        Kuznyechik::Engine::simd,
+        Kuznyechik::Engine::constant_time
+    };
+    ByteBlock key(32);
+    for(size_t i = 0; i < key.size(); i++) key[i] = i;
+
+    for(auto engine : engines) {
+        std::string name = std::string("Kuznyechik ") + engine_name(engine);
+        report(name + " construct", calls_per_second([&] {
+            Kuznyechik cipher(key, engine);
+            key[0]++;
+        }), "keys/s");
+
+        Kuznyechik cipher(key, engine);
+        report(name + " rekey", calls_per_second([&] {
+            cipher.rekey(key.byte_ptr());
+            key[0]++;
+        }), "keys/s");
+    }
+
+    // keys to decrypt with are made on the first decryption
+    for(auto engine : { AesEngine::tables, AesEngine::aesni, AesEngine::bitsliced }) {
+        std::string name = std::string("AES256 ") + aes_engine_name(engine);
+        report(name + " construct", calls_per_second([&] {
+            AES256 cipher(key, engine);
+            key[0]++;
+        }), "keys/s");
+        report(name + " construct to decrypt", calls_per_second([&] {
+            AES256 cipher(key, engine);
+            cipher.prepare_decryption();
+            key[0]++;
+        }), "keys/s");
+    }
+}
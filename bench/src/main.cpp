@@ -0,0 +1,114 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "bench.hpp"
+
+double calls_per_second(const std::function<void()> & f, double min_seconds) {
+    typedef std::chrono::steady_clock clock;
+    f();  // warm up caches and lazy initialization
+
+    unsigned long calls = 0, batch = 1;
+    double elapsed = 0;
+    clock::time_point start = clock::now();
+    while(elapsed < min_seconds) {
+        for(unsigned long i = 0; i < batch; i++) f();
+        calls += batch;
+        batch *= 2;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    }
+    return calls / elapsed;
+}
+
+void report(const std::string & name, double value, const std::string & unit) {
+    printf("%-40s %14.2f %s\n", name.c_str(), value, unit.c_str());
+}
+
+uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+#if defined(__linux__)
+
+EventCounter::EventCounter(Event event) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    if(event == cache_misses) {
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    } else {
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1D |
+            (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+    fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+EventCounter::~EventCounter() {
+    if(fd >= 0) close(fd);
+}
+void EventCounter::start() {
+    if(fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+void EventCounter::stop() {
+    if(fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+}
+long long EventCounter::read() const {
+    long long value;
+    if(fd < 0 || ::read(fd, &value, sizeof value) != sizeof value) return -1;
+    return value;
+}
+
+#else
+
+EventCounter::EventCounter(Event) : fd(-1) {}
+EventCounter::~EventCounter() {}
+void EventCounter::start() {}
+void EventCounter::stop() {}
+long long EventCounter::read() const { return -1; }
+
+#endif
+
+struct Benchmark {
+    const char * name;
+    void (*run)();
+};
+
+static const Benchmark BENCHMARKS[] = {
+    { "keysetup", bench_key_setup },
+    { "footprint", bench_footprint },
+    { "ciphers", bench_ciphers },
+};
+
+// Run the benchmarks named in arguments, all of them without arguments
+int main(int argc, char ** argv) {
+    for(const Benchmark & benchmark : BENCHMARKS) {
+        bool selected = argc < 2;
+        for(int i = 1; i < argc; i++)
+            if(!strcmp(argv[i], benchmark.name)) selected = true;
+        if(selected) benchmark.run();
+    }
+    return 0;
+}
@@ -1,22 +1,72 @@
 #ifndef __KUZNYECHIK__
 #define __KUZNYECHIK__
 
-#include <vector>
+#include <cstdint>
 #include "mycrypto.hpp"
 
 #define BLOCK_LENGTH 16
 
 class Kuznyechik {
-	std::vector<ByteBlock> keys;
-	static bool is_init;
+public:
+	// Implementations of the rounds, they all give the same result.
+	// reference - S and L applied byte by byte as the standard defines them
+	// lookup - S and L fused into 16 tables of 256 precomputed blocks,
+	//          a round is 16 lookups and xors. Decryption uses tables
+	//          of inverse S and L the same way
+	// compact - S through its own table and L through 32 tables of 16 blocks,
+	//           one per nibble: 8 KB per direction instead of 64 KB of
+	//           lookup. Slower in bulk, but leaves caches to the neighbours
+	//           and warms up faster for short messages
+	// simd - the same tables read as whole 128-bit vectors with SSE2,
+	//        falls back to lookup on CPUs other than x86-64
+	// constant_time - no memory access depends on data or keys, so cache
+	//                 timing tells nothing about them. Takes 16 blocks at
+	//                 once with bytes sliced across SSSE3 registers, single
+	//                 blocks cost as much as 16. Never falls back to tables,
+	//                 the constructor throws std::runtime_error on CPUs
+	//                 without SSSE3
+	enum class Engine { reference, lookup, compact, simd, constant_time };
+
+	// The fastest engine this CPU runs
+	static Engine best_engine();
+
+	// The engine ciphers use when none is given to the constructor:
+	// best_engine() until set_default_engine chooses another one.
+	// Safe to call from any thread, ciphers made before keep their engines
+	static Engine default_engine();
+	static void set_default_engine(Engine engine_);
+
+private:
+	// Round keys: 10 of them in a row, then for the table engines
+	// the same keys passed through inverse L to decrypt with
+	ByteBlock schedule;
+	Engine engine;
 public:
 	static const int block_lenght {BLOCK_LENGTH};
 
-	Kuznyechik(const ByteBlock & key);
+	Kuznyechik(ByteView key, Engine engine_ = default_engine());
     Kuznyechik(const Kuznyechik & rhs);
 	~Kuznyechik();
-	void encrypt(const ByteBlock & src, ByteBlock & dst) const;
-	void decrypt(const ByteBlock & src, ByteBlock & dst) const;
+
+	// Derive round keys of another 32-byte key in place, with no
+	// allocations. For protocols that change keys often
+	void rekey(const uint8_t * key);
+
+	// One block of 16 bytes at in to out, which may be in.
+	// No checks, no allocations, nothing thrown
+	void encrypt_block(const uint8_t * in, uint8_t * out) const noexcept;
+	void decrypt_block(const uint8_t * in, uint8_t * out) const noexcept;
+
+	// The same with the block checked to be 16 bytes long,
+	// dst gets resized if it isn't
+	void encrypt(ByteView src, ByteBlock & dst) const;
+	void decrypt(ByteView src, ByteBlock & dst) const;
+
+	// nblocks blocks lying one after another, dst may be src.
+	// Independent blocks go through the rounds together, which hides
+	// latencies of the table lookups
+	void encrypt_blocks(const uint8_t * src, uint8_t * dst, size_t nblocks) const;
+	void decrypt_blocks(const uint8_t * src, uint8_t * dst, size_t nblocks) const;
 };
 
 #endif
@@ -0,0 +1,140 @@
+// Constants of GOST R 34.12-2015 block cipher
+// LINEAR_MATRIX is the linear transform L written as a 16x16 matrix over
+// GF(2^8) with modulus x^8 + x^7 + x^6 + x + 1: column i is L applied to
+// the block with 1 at position i. INVERSE_LINEAR_MATRIX is the same for
+// inverse L. ITERATION_CONSTANTS[i - 1] is L of the block with i
+// at the last position
+
+const unsigned AMOUNT_OF_ITER_CONSTS = 32;
+
+constexpr BYTE SUBSTITUTION_PI [ 256 ] =
+{
+    252, 238, 221,  17, 207, 110,  49,  22, 251, 196, 250,
+    218,  35, 197,   4,  77, 233, 119, 240, 219, 147,  46,
+    153, 186,  23,  54, 241, 187,  20, 205,  95, 193, 249,
+     24, 101,  90, 226,  92, 239,  33, 129,  28,  60,  66,
+    139,   1, 142,  79,   5, 132,   2, 174, 227, 106, 143,
+    160,   6,  11, 237, 152, 127, 212, 211,  31, 235,  52,
+     44,  81, 234, 200,  72, 171, 242,  42, 104, 162, 253,
+     58, 206, 204, 181, 112,  14,  86,   8,  12, 118,  18,
+    191, 114,  19,  71, 156, 183,  93, 135,  21, 161, 150,
+     41,  16, 123, 154, 199, 243, 145, 120, 111, 157, 158,
+    178, 177,  50, 117,  25,  61, 255,  53, 138, 126, 109,
+     84, 198, 128, 195, 189,  13,  87, 223, 245,  36, 169,
+     62, 168,  67, 201, 215, 121, 214, 246, 124,  34, 185,
+      3, 224,  15, 236, 222, 122, 148, 176, 188, 220, 232,
+     40,  80,  78,  51,  10,  74, 167, 151,  96, 115,  30,
+      0,  98,  68,  26, 184,  56, 130, 100, 159,  38,  65,
+    173,  69,  70, 146,  39,  94,  85,  47, 140, 163, 165,
+    125, 105, 213, 149,  59,   7,  88, 179,  64, 134, 172,
+     29, 247,  48,  55, 107, 228, 136, 217, 231, 137, 225,
+     27, 131,  73,  76,  63, 248, 254, 141,  83, 170, 144,
+    202, 216, 133,  97,  32, 113, 103, 164,  45,  43,   9,
+     91, 203, 155,  37, 208, 190, 229, 108,  82,  89, 166,
+    116, 210, 230, 244, 180, 192, 209, 102, 175, 194,  57,
+     75,  99, 182
+};
+
+constexpr BYTE INVERSE_SUBSTITUTION_PI [ 256 ] =
+{
+    165,  45,  50, 143,  14,  48,  56, 192,  84, 230, 158,
+     57,  85, 126,  82, 145, 100,   3,  87,  90,  28,  96,
+      7,  24,  33, 114, 168, 209,  41, 198, 164,  63, 224,
+     39, 141,  12, 130, 234, 174, 180, 154,  99,  73, 229,
+     66, 228,  21, 183, 200,   6, 112, 157,  65, 117,  25,
+    201, 170, 252,  77, 191,  42, 115, 132, 213, 195, 175,
+     43, 134, 167, 177, 178,  91,  70, 211, 159, 253, 212,
+     15, 156,  47, 155,  67, 239, 217, 121, 182,  83, 127,
+    193, 240,  35, 231,  37,  94, 181,  30, 162, 223, 166,
+    254, 172,  34, 249, 226,  74, 188,  53, 202, 238, 120,
+      5, 107,  81, 225,  89, 163, 242, 113,  86,  17, 106,
+    137, 148, 101, 140, 187, 119,  60, 123,  40, 171, 210,
+     49, 222, 196,  95, 204, 207, 118,  44, 184, 216,  46,
+     54, 219, 105, 179,  20, 149, 190,  98, 161,  59,  22,
+    102, 233,  92, 108, 109, 173,  55,  97,  75, 185, 227,
+    186, 241, 160, 133, 131, 218,  71, 197, 176,  51, 250,
+    150, 111, 110, 194, 246,  80, 255,  93, 169, 142,  23,
+     27, 151, 125, 236,  88, 247,  31, 251, 124,   9,  13,
+    122, 103,  69, 135, 220, 232,  79,  29,  78,   4, 235,
+    248, 243,  62,  61, 189, 138, 136, 221, 205,  11,  19,
+    152,   2, 147, 128, 144, 208,  36,  52, 203, 237, 244,
+    206, 153,  16,  68,  64, 146,  58,   1,  38,  18,  26,
+     72, 104, 245, 129, 139, 199, 214,  32,  10,   8,   0,
+     76, 215, 116
+};
+
+constexpr BYTE LINEAR_MATRIX [ BLOCK_LENGTH ][ BLOCK_LENGTH ] =
+{
+    { 0xcf, 0x98, 0x74, 0xbf, 0x93, 0x8e, 0xf2, 0xf3, 0x0a, 0xbf, 0xf6, 0xa9, 0xea, 0x8e, 0x4d, 0x6e },
+    { 0x6e, 0x20, 0xc6, 0xda, 0x90, 0x48, 0x89, 0x9c, 0xc1, 0x64, 0xb8, 0x2d, 0x86, 0x44, 0xd0, 0xa2 },
+    { 0xa2, 0xc8, 0x87, 0x70, 0x68, 0x43, 0x1c, 0x2b, 0xa1, 0x63, 0x30, 0x6b, 0x9f, 0x30, 0xe3, 0x76 },
+    { 0x76, 0x33, 0x10, 0x0c, 0x1c, 0x11, 0xd6, 0x6a, 0xa6, 0xd7, 0xf6, 0x49, 0x07, 0x14, 0xe8, 0x72 },
+    { 0x72, 0xf2, 0x6b, 0xca, 0x20, 0xeb, 0x02, 0xa4, 0x8d, 0xd4, 0xc4, 0x01, 0x65, 0xdd, 0x4c, 0x6c },
+    { 0x6c, 0x76, 0xec, 0x0c, 0xc5, 0xbc, 0xaf, 0x6e, 0xa3, 0xe1, 0x90, 0x58, 0x0e, 0x02, 0xc3, 0x48 },
+    { 0x48, 0xd5, 0x62, 0x17, 0x06, 0x2d, 0xc4, 0xe7, 0xd5, 0xeb, 0x99, 0x78, 0x52, 0xf5, 0x16, 0x7a },
+    { 0x7a, 0xe6, 0x4e, 0x1a, 0xbb, 0x2e, 0xf1, 0xbe, 0xd4, 0xaf, 0x37, 0xb1, 0xd4, 0x2a, 0x6e, 0xb8 },
+    { 0xb8, 0x49, 0x87, 0x14, 0xcb, 0x8d, 0xab, 0x49, 0x09, 0x6c, 0x2a, 0x01, 0x60, 0x8e, 0x4b, 0x5d },
+    { 0x5d, 0xd4, 0xb8, 0x2f, 0x8d, 0x12, 0xee, 0xf6, 0x08, 0x54, 0x0f, 0xf3, 0x98, 0xc8, 0x7f, 0x27 },
+    { 0x27, 0x9f, 0xbe, 0x68, 0x1a, 0x7c, 0xad, 0xc9, 0x84, 0x2f, 0xeb, 0xfe, 0xc6, 0x48, 0xa2, 0xbd },
+    { 0xbd, 0x95, 0x5e, 0x30, 0xe9, 0x60, 0xbf, 0x10, 0xef, 0x39, 0xec, 0x91, 0x7f, 0x48, 0x89, 0x10 },
+    { 0x10, 0xe9, 0xd0, 0xd9, 0xf3, 0x94, 0x3d, 0xaf, 0x7b, 0xff, 0x64, 0x91, 0x52, 0xf8, 0x0d, 0xdd },
+    { 0xdd, 0x99, 0x75, 0xca, 0x97, 0x44, 0x5a, 0xe0, 0x30, 0xa6, 0x31, 0xd3, 0xdf, 0x48, 0x64, 0x84 },
+    { 0x84, 0x2d, 0x74, 0x96, 0x5d, 0x77, 0x6f, 0xde, 0x54, 0xb4, 0x8d, 0xd1, 0x44, 0x3c, 0xa5, 0x94 },
+    { 0x94, 0x20, 0x85, 0x10, 0xc2, 0xc0, 0x01, 0xfb, 0x01, 0xc0, 0xc2, 0x10, 0x85, 0x20, 0x94, 0x01 }
+};
+
+constexpr BYTE INVERSE_LINEAR_MATRIX [ BLOCK_LENGTH ][ BLOCK_LENGTH ] =
+{
+    { 0x01, 0x94, 0x20, 0x85, 0x10, 0xc2, 0xc0, 0x01, 0xfb, 0x01, 0xc0, 0xc2, 0x10, 0x85, 0x20, 0x94 },
+    { 0x94, 0xa5, 0x3c, 0x44, 0xd1, 0x8d, 0xb4, 0x54, 0xde, 0x6f, 0x77, 0x5d, 0x96, 0x74, 0x2d, 0x84 },
+    { 0x84, 0x64, 0x48, 0xdf, 0xd3, 0x31, 0xa6, 0x30, 0xe0, 0x5a, 0x44, 0x97, 0xca, 0x75, 0x99, 0xdd },
+    { 0xdd, 0x0d, 0xf8, 0x52, 0x91, 0x64, 0xff, 0x7b, 0xaf, 0x3d, 0x94, 0xf3, 0xd9, 0xd0, 0xe9, 0x10 },
+    { 0x10, 0x89, 0x48, 0x7f, 0x91, 0xec, 0x39, 0xef, 0x10, 0xbf, 0x60, 0xe9, 0x30, 0x5e, 0x95, 0xbd },
+    { 0xbd, 0xa2, 0x48, 0xc6, 0xfe, 0xeb, 0x2f, 0x84, 0xc9, 0xad, 0x7c, 0x1a, 0x68, 0xbe, 0x9f, 0x27 },
+    { 0x27, 0x7f, 0xc8, 0x98, 0xf3, 0x0f, 0x54, 0x08, 0xf6, 0xee, 0x12, 0x8d, 0x2f, 0xb8, 0xd4, 0x5d },
+    { 0x5d, 0x4b, 0x8e, 0x60, 0x01, 0x2a, 0x6c, 0x09, 0x49, 0xab, 0x8d, 0xcb, 0x14, 0x87, 0x49, 0xb8 },
+    { 0xb8, 0x6e, 0x2a, 0xd4, 0xb1, 0x37, 0xaf, 0xd4, 0xbe, 0xf1, 0x2e, 0xbb, 0x1a, 0x4e, 0xe6, 0x7a },
+    { 0x7a, 0x16, 0xf5, 0x52, 0x78, 0x99, 0xeb, 0xd5, 0xe7, 0xc4, 0x2d, 0x06, 0x17, 0x62, 0xd5, 0x48 },
+    { 0x48, 0xc3, 0x02, 0x0e, 0x58, 0x90, 0xe1, 0xa3, 0x6e, 0xaf, 0xbc, 0xc5, 0x0c, 0xec, 0x76, 0x6c },
+    { 0x6c, 0x4c, 0xdd, 0x65, 0x01, 0xc4, 0xd4, 0x8d, 0xa4, 0x02, 0xeb, 0x20, 0xca, 0x6b, 0xf2, 0x72 },
+    { 0x72, 0xe8, 0x14, 0x07, 0x49, 0xf6, 0xd7, 0xa6, 0x6a, 0xd6, 0x11, 0x1c, 0x0c, 0x10, 0x33, 0x76 },
+    { 0x76, 0xe3, 0x30, 0x9f, 0x6b, 0x30, 0x63, 0xa1, 0x2b, 0x1c, 0x43, 0x68, 0x70, 0x87, 0xc8, 0xa2 },
+    { 0xa2, 0xd0, 0x44, 0x86, 0x2d, 0xb8, 0x64, 0xc1, 0x9c, 0x89, 0x48, 0x90, 0xda, 0xc6, 0x20, 0x6e },
+    { 0x6e, 0x4d, 0x8e, 0xea, 0xa9, 0xf6, 0xbf, 0x0a, 0xf3, 0xf2, 0x8e, 0x93, 0xbf, 0x74, 0x98, 0xcf }
+};
+
+constexpr BYTE ITERATION_CONSTANTS [ AMOUNT_OF_ITER_CONSTS ][ BLOCK_LENGTH ] =
+{
+    { 0x6e, 0xa2, 0x76, 0x72, 0x6c, 0x48, 0x7a, 0xb8, 0x5d, 0x27, 0xbd, 0x10, 0xdd, 0x84, 0x94, 0x01 },
+    { 0xdc, 0x87, 0xec, 0xe4, 0xd8, 0x90, 0xf4, 0xb3, 0xba, 0x4e, 0xb9, 0x20, 0x79, 0xcb, 0xeb, 0x02 },
+    { 0xb2, 0x25, 0x9a, 0x96, 0xb4, 0xd8, 0x8e, 0x0b, 0xe7, 0x69, 0x04, 0x30, 0xa4, 0x4f, 0x7f, 0x03 },
+    { 0x7b, 0xcd, 0x1b, 0x0b, 0x73, 0xe3, 0x2b, 0xa5, 0xb7, 0x9c, 0xb1, 0x40, 0xf2, 0x55, 0x15, 0x04 },
+    { 0x15, 0x6f, 0x6d, 0x79, 0x1f, 0xab, 0x51, 0x1d, 0xea, 0xbb, 0x0c, 0x50, 0x2f, 0xd1, 0x81, 0x05 },
+    { 0xa7, 0x4a, 0xf7, 0xef, 0xab, 0x73, 0xdf, 0x16, 0x0d, 0xd2, 0x08, 0x60, 0x8b, 0x9e, 0xfe, 0x06 },
+    { 0xc9, 0xe8, 0x81, 0x9d, 0xc7, 0x3b, 0xa5, 0xae, 0x50, 0xf5, 0xb5, 0x70, 0x56, 0x1a, 0x6a, 0x07 },
+    { 0xf6, 0x59, 0x36, 0x16, 0xe6, 0x05, 0x56, 0x89, 0xad, 0xfb, 0xa1, 0x80, 0x27, 0xaa, 0x2a, 0x08 },
+    { 0x98, 0xfb, 0x40, 0x64, 0x8a, 0x4d, 0x2c, 0x31, 0xf0, 0xdc, 0x1c, 0x90, 0xfa, 0x2e, 0xbe, 0x09 },
+    { 0x2a, 0xde, 0xda, 0xf2, 0x3e, 0x95, 0xa2, 0x3a, 0x17, 0xb5, 0x18, 0xa0, 0x5e, 0x61, 0xc1, 0x0a },
+    { 0x44, 0x7c, 0xac, 0x80, 0x52, 0xdd, 0xd8, 0x82, 0x4a, 0x92, 0xa5, 0xb0, 0x83, 0xe5, 0x55, 0x0b },
+    { 0x8d, 0x94, 0x2d, 0x1d, 0x95, 0xe6, 0x7d, 0x2c, 0x1a, 0x67, 0x10, 0xc0, 0xd5, 0xff, 0x3f, 0x0c },
+    { 0xe3, 0x36, 0x5b, 0x6f, 0xf9, 0xae, 0x07, 0x94, 0x47, 0x40, 0xad, 0xd0, 0x08, 0x7b, 0xab, 0x0d },
+    { 0x51, 0x13, 0xc1, 0xf9, 0x4d, 0x76, 0x89, 0x9f, 0xa0, 0x29, 0xa9, 0xe0, 0xac, 0x34, 0xd4, 0x0e },
+    { 0x3f, 0xb1, 0xb7, 0x8b, 0x21, 0x3e, 0xf3, 0x27, 0xfd, 0x0e, 0x14, 0xf0, 0x71, 0xb0, 0x40, 0x0f },
+    { 0x2f, 0xb2, 0x6c, 0x2c, 0x0f, 0x0a, 0xac, 0xd1, 0x99, 0x35, 0x81, 0xc3, 0x4e, 0x97, 0x54, 0x10 },
+    { 0x41, 0x10, 0x1a, 0x5e, 0x63, 0x42, 0xd6, 0x69, 0xc4, 0x12, 0x3c, 0xd3, 0x93, 0x13, 0xc0, 0x11 },
+    { 0xf3, 0x35, 0x80, 0xc8, 0xd7, 0x9a, 0x58, 0x62, 0x23, 0x7b, 0x38, 0xe3, 0x37, 0x5c, 0xbf, 0x12 },
+    { 0x9d, 0x97, 0xf6, 0xba, 0xbb, 0xd2, 0x22, 0xda, 0x7e, 0x5c, 0x85, 0xf3, 0xea, 0xd8, 0x2b, 0x13 },
+    { 0x54, 0x7f, 0x77, 0x27, 0x7c, 0xe9, 0x87, 0x74, 0x2e, 0xa9, 0x30, 0x83, 0xbc, 0xc2, 0x41, 0x14 },
+    { 0x3a, 0xdd, 0x01, 0x55, 0x10, 0xa1, 0xfd, 0xcc, 0x73, 0x8e, 0x8d, 0x93, 0x61, 0x46, 0xd5, 0x15 },
+    { 0x88, 0xf8, 0x9b, 0xc3, 0xa4, 0x79, 0x73, 0xc7, 0x94, 0xe7, 0x89, 0xa3, 0xc5, 0x09, 0xaa, 0x16 },
+    { 0xe6, 0x5a, 0xed, 0xb1, 0xc8, 0x31, 0x09, 0x7f, 0xc9, 0xc0, 0x34, 0xb3, 0x18, 0x8d, 0x3e, 0x17 },
+    { 0xd9, 0xeb, 0x5a, 0x3a, 0xe9, 0x0f, 0xfa, 0x58, 0x34, 0xce, 0x20, 0x43, 0x69, 0x3d, 0x7e, 0x18 },
+    { 0xb7, 0x49, 0x2c, 0x48, 0x85, 0x47, 0x80, 0xe0, 0x69, 0xe9, 0x9d, 0x53, 0xb4, 0xb9, 0xea, 0x19 },
+    { 0x05, 0x6c, 0xb6, 0xde, 0x31, 0x9f, 0x0e, 0xeb, 0x8e, 0x80, 0x99, 0x63, 0x10, 0xf6, 0x95, 0x1a },
+    { 0x6b, 0xce, 0xc0, 0xac, 0x5d, 0xd7, 0x74, 0x53, 0xd3, 0xa7, 0x24, 0x73, 0xcd, 0x72, 0x01, 0x1b },
+    { 0xa2, 0x26, 0x41, 0x31, 0x9a, 0xec, 0xd1, 0xfd, 0x83, 0x52, 0x91, 0x03, 0x9b, 0x68, 0x6b, 0x1c },
+    { 0xcc, 0x84, 0x37, 0x43, 0xf6, 0xa4, 0xab, 0x45, 0xde, 0x75, 0x2c, 0x13, 0x46, 0xec, 0xff, 0x1d },
+    { 0x7e, 0xa1, 0xad, 0xd5, 0x42, 0x7c, 0x25, 0x4e, 0x39, 0x1c, 0x28, 0x23, 0xe2, 0xa3, 0x80, 0x1e },
+    { 0x10, 0x03, 0xdb, 0xa7, 0x2e, 0x34, 0x5f, 0xf6, 0x64, 0x3b, 0x95, 0x33, 0x3f, 0x27, 0x14, 0x1f },
+    { 0x5e, 0xa7, 0xd8, 0x58, 0x1e, 0x14, 0x9b, 0x61, 0xf1, 0x6a, 0xc1, 0x45, 0x9c, 0xed, 0xa8, 0x20 }
+};
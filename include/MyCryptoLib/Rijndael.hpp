@@ -1,7 +1,8 @@
 #ifndef __RIJNDAEL__
 #define __RIJNDAEL__
 
-#include <vector>
+#include <atomic>
+#include <cstdint>
 #include "mycrypto.hpp"
 #include "rawbytes.hpp"
 
@@ -9,36 +10,62 @@
 
 typedef unsigned int uint;
 
-struct SBoxContainer {
-    static bool is_init;
-    static raw_bytes::byte sbox[256];
-    static raw_bytes::byte invsbox[256];
-    static void init();
-};
+// Implementations of AES rounds, they all give the same result.
+// Rijndael with other block sizes has got just one of its own
+// tables - four T-tables of 1 KB for each direction, 32-bit round keys
+// aesni - AES-NI instructions with 8 blocks in flight,
+//         falls back to tables on CPUs without them
+// bitsliced - 8 blocks at once with each bit of their bytes in planes
+//             of logic operations, no memory access depends on data or
+//             keys, key schedule included. Single blocks cost as much
+//             as 8. For CPUs without AES-NI where tables leak timings
+enum class AesEngine { tables, aesni, bitsliced };
 
-template <uint Nr>
-struct RConstContainer {
-    static bool is_init;
-    static raw_bytes::dword rconst[Nr];
-    static void init();
-};
+// The fastest engine this CPU runs, ciphers use it by default
+AesEngine best_aes_engine();
 
 // Nk - number of dwords for key
 // Nb - number of dwords for block
 // Nr = number of rounds in key expansion
 template <uint Nk, uint Nb, uint Nr>
-class Rijndael : public SBoxContainer, public RConstContainer<Nr> {
-    std::vector<ByteBlock>          round_keys;
+class Rijndael {
+    // Round keys in the form the rounds for this Nb take them:
+    // bytes in a row, or 32-bit words for AES with its T-tables.
+    // AES engines decrypt with keys of their own, made of those to
+    // encrypt with on the first decryption. Ciphers which only
+    // encrypt, as in CFB, OFB or key wrapping, never pay for them
+    mutable ByteBlock               schedule;
+    AesEngine                       engine;
+    mutable std::atomic<bool>       inverse_ready;
 
 public:
 	static const int                block_lenght { Nb * DWORD };
 
-	Rijndael(const ByteBlock & key);
+	Rijndael(ByteView key, AesEngine engine_ = best_aes_engine());
     Rijndael(const Rijndael & rhs);
+    Rijndael & operator = (const Rijndael & rhs);
 	~Rijndael() {};
 
-    void encrypt(const ByteBlock & src, ByteBlock & dst) const;
-	void decrypt(const ByteBlock & src, ByteBlock & dst) const;
+    // Makes the keys to decrypt with now rather than on the first
+    // decryption, for those who count latency of it. Safe to call
+    // from any thread, does nothing once they are made
+    void prepare_decryption() const noexcept;
+
+    // One block at in to out, which may be in.
+    // No checks, no allocations, nothing thrown. The first decryption
+    // of a cipher makes its keys to decrypt with, other threads
+    // decrypting at that moment spin until they are made
+    void encrypt_block(const uint8_t * in, uint8_t * out) const noexcept;
+    void decrypt_block(const uint8_t * in, uint8_t * out) const noexcept;
+
+    // The same with the length of the block checked,
+    // dst gets resized if it isn't block_lenght long
+    void encrypt(ByteView src, ByteBlock & dst) const;
+	void decrypt(ByteView src, ByteBlock & dst) const;
+
+    // nblocks blocks lying one after another, dst may be src
+    void encrypt_blocks(const uint8_t * src, uint8_t * dst, size_t nblocks) const;
+    void decrypt_blocks(const uint8_t * src, uint8_t * dst, size_t nblocks) const;
 };
 
 typedef Rijndael<4, 4, 10> AES128;
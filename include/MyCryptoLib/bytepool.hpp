@@ -0,0 +1,53 @@
+#include <cstddef>
+#include <cstdint>
+
+#ifndef __BYTEPOOL__
+#define __BYTEPOOL__
+
+typedef unsigned char BYTE;
+
+struct BytePoolStats {
+    uint64_t hits;          // requests served from a freelist
+    uint64_t misses;        // requests which went to the heap
+    uint64_t bytes_held;    // bytes parked in freelists of all threads
+};
+
+// Size-class pool which stands behind heap bodies of ByteBlock.
+// Every thread keeps its own freelists, so acquire and recycle never
+// lock. Sensitive buffers are wiped by ByteBlock before they come back
+// here, so the freelists hold no secrets.
+// Every buffer starts at a cache line boundary
+class BytePool {
+public:
+    static const size_t alignment = 64;
+
+    // Bodies from min_class up to max_class bytes are rounded up to
+    // the nearest power of two and recycled, others go to the heap as is
+    static const size_t min_class = 128;
+    static const size_t max_class = 64 * 1024;
+    // One thread never parks more than this amount of bytes
+    static const size_t max_bytes_per_thread = 1024 * 1024;
+
+    // Real size of the buffer acquire(size_) returns
+    static size_t capacity_for(size_t size_);
+    // Return buffer which can hold capacity_for(size_) bytes
+    static BYTE * acquire(size_t size_);
+    // Take back buffer returned by acquire(size_)
+    // Passing its capacity_for(size_) instead of size_ is fine as well
+    static void recycle(BYTE * ptr, size_t size_);
+
+    // Global switch, the pool is enabled by default
+    // Disabled pool neither serves nor keeps buffers
+    static void set_enabled(bool value);
+    static bool enabled();
+
+    // Free all buffers parked by the calling thread
+    static void trim();
+
+    // Every thread counts for itself, these calls sum the counters up
+    // under a lock taken nowhere else but at start and end of threads
+    static BytePoolStats statistics();
+    static void reset_statistics();
+};
+
+#endif
@@ -0,0 +1,46 @@
+#include <cstddef>
+#include <cstdint>
+
+#ifndef __BYTESTATS__
+#define __BYTESTATS__
+
+struct ByteCounters {
+    uint64_t allocations;       // heap bodies taken by blocks
+    uint64_t bytes_allocated;   // their capacity in total
+    uint64_t deep_copies;       // blocks made as copies of other bytes
+    uint64_t bytes_copied;
+    uint64_t wipes;             // calls to secure_zero on behalf of blocks
+    uint64_t bytes_wiped;
+    int64_t live_bytes;         // heap bytes held by blocks right now
+    int64_t peak_live_bytes;    // the maximum of live_bytes so far
+};
+
+// Accounting of what ByteBlock costs besides the real cipher work.
+// It is off by default, and a disabled one costs a single relaxed load
+// per event. It's switched on by building with -DMYCRYPTO_ACCOUNTING,
+// by setting environment variable MYCRYPTO_ACCOUNTING to anything but "0"
+// or with set_enabled(true).
+// Counters are kept for the whole process and for every thread. Bodies
+// allocated while accounting was off and released while it's on
+// make live_bytes drop below zero, so switch it on before the work
+// to be measured starts
+class ByteStats {
+public:
+    static void set_enabled(bool value);
+    static bool enabled();
+
+    static ByteCounters global();
+    static ByteCounters this_thread();
+
+    // Zero the global counters and those of the calling thread,
+    // peaks start over from current live_bytes
+    static void reset();
+
+    // Hooks called by ByteBlock
+    static void on_allocate(size_t n_bytes);
+    static void on_release(size_t n_bytes);
+    static void on_copy(size_t n_bytes);
+    static void on_wipe(size_t n_bytes);
+};
+
+#endif
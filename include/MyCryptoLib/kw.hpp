@@ -2,8 +2,8 @@
 #include "Rijndael.hpp"
 
 
-void KeyWrapFunction(ByteBlock & dst, const ByteBlock & src, const ByteBlock & key);
-void KeyUnwrapFunction(ByteBlock & dst, const ByteBlock & src, const ByteBlock & key);
+void KeyWrapFunction(ByteBlock & dst, ByteView src, ByteView key);
+void KeyUnwrapFunction(ByteBlock & dst, ByteView src, ByteView key);
 
-void KeyWrapPaddedFunction(ByteBlock & dst, const ByteBlock & str, const ByteBlock & key);
-void KeyUnwrapPaddedFunction(ByteBlock & dst, const ByteBlock & str, const ByteBlock & key);
+void KeyWrapPaddedFunction(ByteBlock & dst, ByteView str, ByteView key);
+void KeyUnwrapPaddedFunction(ByteBlock & dst, ByteView str, ByteView key);
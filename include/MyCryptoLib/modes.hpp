@@ -2,54 +2,138 @@
 #include <algorithm>
 #include <functional>
 #include <stdexcept>
+#include <cstring>
+
+#include "rawbytes.hpp"
 
 /*----------------------- Cipher Feed Back Mode ------------------------------*/
 template <typename CipherType>
-CFB_Mode<CipherType>::CFB_Mode(const CipherType & alg, const ByteBlock & init_vec) :
+CFB_Mode<CipherType>::CFB_Mode(const CipherType & alg, ByteView init_vec) :
     algorithm(alg), iv(init_vec.deep_copy())
 {
     // nothing
 }
 
 template <typename CipherType>
-void CFB_Mode<CipherType>::encrypt(const ByteBlock & src, ByteBlock & dst) const {
-    auto blocks = split_blocks(src, CipherType::block_lenght);
-    ByteBlock tmp;
+void CFB_Mode<CipherType>::encrypt(ByteView src, ByteBlock & dst) const {
+    ByteBlock holder;
+    BYTE * output = prepare_output(src, dst, holder);
+    encrypt(src, output);
+    dst.set_sensitivity(Sensitivity::nonsensitive);
+}
+
+template <typename CipherType>
+void CFB_Mode<CipherType>::encrypt(ByteView src, BYTE * dst) const {
+    const size_t block_lenght = CipherType::block_lenght;
+    BYTE gamma[block_lenght];
+    const BYTE * feedback = iv.byte_ptr();
 
-    algorithm.encrypt(iv, tmp);
-    xor_blocks(tmp, tmp, blocks[0]);
-    blocks[0] = std::move(tmp);
-    for(int i = 1; i < blocks.size(); i++) {
-        algorithm.encrypt(blocks[i-1], tmp);
-        xor_blocks(tmp, tmp, blocks[i]);
-        blocks[i] = std::move(tmp);
+    for(size_t pos = 0; pos < src.size(); pos += block_lenght) {
+        size_t length = std::min(block_lenght, src.size() - pos);
+        algorithm.encrypt_block(feedback, gamma);
+        raw_bytes::xor_n(dst + pos, src.byte_ptr() + pos, gamma, length);
+        // only a whole block may be followed by another one
+        feedback = dst + pos;
     }
-    dst = join_blocks(blocks);
+    raw_bytes::secure_zero(gamma, block_lenght);
 }
 
 template <typename CipherType>
-void CFB_Mode<CipherType>::decrypt_with_iv(const ByteBlock & src, ByteBlock & dst, const ByteBlock & iv_) const {
-    auto blocks = split_blocks(src, CipherType::block_lenght);
-	ByteBlock tmp;
+void CFB_Mode<CipherType>::decrypt_with_iv(ByteView src, BYTE * dst, ByteView iv_) const {
+    const size_t block_lenght = CipherType::block_lenght;
+    // Gamma of a block is the ciphertext before it encrypted, all of them
+    // are known in advance, so gammas of a chunk go to the cipher at once
+    const size_t chunk = 8 * block_lenght;
+    BYTE gamma[chunk];
+    // dst may be src, so the ciphertext to feed back is saved aside
+    BYTE feedback[block_lenght];
+    memcpy(feedback, iv_.byte_ptr(), block_lenght);
 
-	algorithm.encrypt(iv_, tmp);
-	xor_blocks(tmp, blocks[0], tmp);
-	swap(tmp, blocks[0]);
-	for(int i = 1; i < blocks.size(); i++) {
-		algorithm.encrypt(tmp, tmp);
-		xor_blocks(tmp, blocks[i], tmp);
-		swap(tmp, blocks[i]);
-	}
-	dst = join_blocks(blocks);
+    for(size_t pos = 0; pos < src.size(); pos += chunk) {
+        size_t length = std::min(chunk, src.size() - pos);
+        size_t n_blocks = (length + block_lenght - 1) / block_lenght;
+        const BYTE * in = src.byte_ptr() + pos;
+        memcpy(gamma, feedback, block_lenght);
+        memcpy(gamma + block_lenght, in, (n_blocks - 1) * block_lenght);
+        if(length == chunk)
+            memcpy(feedback, in + chunk - block_lenght, block_lenght);
+        algorithm.encrypt_blocks(gamma, gamma, n_blocks);
+        raw_bytes::xor_n(dst + pos, in, gamma, length);
+    }
+    raw_bytes::secure_zero(gamma, chunk);
 }
 
 template <typename CipherType>
-void CFB_Mode<CipherType>::decrypt(const ByteBlock & src, ByteBlock & dst) const {
+void CFB_Mode<CipherType>::decrypt(ByteView src, ByteBlock & dst) const {
+    ByteBlock holder;
+    BYTE * output = prepare_output(src, dst, holder);
+    decrypt(src, output);
+    dst.set_sensitivity(Sensitivity::sensitive);
+}
+
+template <typename CipherType>
+void CFB_Mode<CipherType>::decrypt(ByteView src, BYTE * dst) const {
 	decrypt_with_iv(src, dst, iv);
 }
 
 template <typename CipherType>
-void CFB_Mode<CipherType>::parallel_decrypt(const ByteBlock & src, ByteBlock & dst) const {
+void CFB_Mode<CipherType>::encrypt(SegmentReader & src, SegmentWriter & dst) const {
+    const size_t block_lenght = CipherType::block_lenght;
+    if(dst.remaining() < src.remaining())
+        throw std::length_error("Output segments are shorter than the message");
+
+    BYTE input[block_lenght], output[block_lenght];
+    BYTE gamma[block_lenght], feedback[block_lenght];
+    memcpy(feedback, iv.byte_ptr(), block_lenght);
+
+    while(src.remaining()) {
+        size_t length = std::min(block_lenght, src.remaining());
+        const BYTE * in = src.read(length, input);
+        BYTE * out = dst.peek(length, output);
+        algorithm.encrypt_block(feedback, gamma);
+        raw_bytes::xor_n(out, in, gamma, length);
+        if(length == block_lenght)
+            memcpy(feedback, out, block_lenght);
+        dst.write(out, length);
+    }
+    raw_bytes::secure_zero(input, block_lenght);
+    raw_bytes::secure_zero(gamma, block_lenght);
+}
+
+template <typename CipherType>
+void CFB_Mode<CipherType>::decrypt(SegmentReader & src, SegmentWriter & dst) const {
+    const size_t block_lenght = CipherType::block_lenght;
+    if(dst.remaining() < src.remaining())
+        throw std::length_error("Output segments are shorter than the message");
+
+    BYTE input[block_lenght], output[block_lenght];
+    BYTE gamma[block_lenght], feedback[block_lenght];
+    memcpy(feedback, iv.byte_ptr(), block_lenght);
+
+    while(src.remaining()) {
+        size_t length = std::min(block_lenght, src.remaining());
+        const BYTE * in = src.read(length, input);
+        BYTE * out = dst.peek(length, output);
+        algorithm.encrypt_block(feedback, gamma);
+        if(length == block_lenght)
+            memcpy(feedback, in, block_lenght);
+        raw_bytes::xor_n(out, in, gamma, length);
+        dst.write(out, length);
+    }
+    raw_bytes::secure_zero(output, block_lenght);
+    raw_bytes::secure_zero(gamma, block_lenght);
+}
+
+template <typename CipherType>
+void CFB_Mode<CipherType>::parallel_decrypt(ByteView src, ByteBlock & dst) const {
+    ByteBlock holder;
+    BYTE * output = prepare_output(src, dst, holder);
+    parallel_decrypt(src, output);
+    dst.set_sensitivity(Sensitivity::sensitive);
+}
+
+template <typename CipherType>
+void CFB_Mode<CipherType>::parallel_decrypt(ByteView src, BYTE * dst) const {
     // length in blocks of CipherType::block_lenght
     unsigned long const length =
         src.size() / CipherType::block_lenght + (src.size() % CipherType::block_lenght ? 1 : 0);
@@ -76,13 +160,13 @@ void CFB_Mode<CipherType>::parallel_decrypt(const ByteBlock & src, ByteBlock & d
     }
 
     unsigned long const block_size = (length / num_threads) * CipherType::block_lenght;
+    // copied, since decryption in place overwrites them
     std::vector<ByteBlock> init_vectors(num_threads);
-    std::vector<ByteBlock> results(num_threads);
     std::vector<std::thread> threads(num_threads - 1);
 
     init_vectors[0] = iv.deep_copy();
     for(int i = 1; i < num_threads; i++)
-        init_vectors[i] = src(i * block_size - CipherType::block_lenght, CipherType::block_lenght);
+        init_vectors[i] = src(i * block_size - CipherType::block_lenght, CipherType::block_lenght).deep_copy();
 
     unsigned long start_pos = 0;
     for(unsigned long i = 0; i < num_threads - 1; i++) {
@@ -90,49 +174,88 @@ void CFB_Mode<CipherType>::parallel_decrypt(const ByteBlock & src, ByteBlock & d
             &CFB_Mode<CipherType>::decrypt_with_iv,
             this,
             src(start_pos, block_size),
-            std::ref( results[i] ),
-            std::ref( init_vectors[i] )
+            dst + start_pos,
+            ByteView(init_vectors[i])
         );
         start_pos += block_size;
     }
 
     decrypt_with_iv(
         src(start_pos, src.size() - start_pos),
-        results[num_threads - 1],
+        dst + start_pos,
         init_vectors[num_threads - 1]
     );
 
     for(auto & t : threads) t.join();
-
-    dst = join_blocks(results);
 }
 
 
 /*------------------------- Output Feed Back Mode ----------------------------*/
 template <typename CipherType>
-OFB_Mode<CipherType>::OFB_Mode(const CipherType & alg, const ByteBlock & init_vec) :
+OFB_Mode<CipherType>::OFB_Mode(const CipherType & alg, ByteView init_vec) :
     algorithm(alg), iv(init_vec.deep_copy())
 {
     // nothing
 }
 
 template <typename CipherType>
-void OFB_Mode<CipherType>::encrypt(const ByteBlock & src, ByteBlock & dst) const {
-    auto blocks = split_blocks(src, CipherType::block_lenght);
-	ByteBlock tmp;
+void OFB_Mode<CipherType>::encrypt(ByteView src, ByteBlock & dst) const {
+    ByteBlock holder;
+    BYTE * output = prepare_output(src, dst, holder);
+    encrypt(src, output);
+	dst.set_sensitivity(Sensitivity::nonsensitive);
+}
+
+template <typename CipherType>
+void OFB_Mode<CipherType>::encrypt(ByteView src, BYTE * dst) const {
+    const size_t block_lenght = CipherType::block_lenght;
+	BYTE gamma[block_lenght];
+
+	algorithm.encrypt_block(iv.byte_ptr(), gamma);
+    for(size_t pos = 0; pos < src.size(); pos += block_lenght) {
+        if(pos) algorithm.encrypt_block(gamma, gamma);
+        size_t length = std::min(block_lenght, src.size() - pos);
+        raw_bytes::xor_n(dst + pos, src.byte_ptr() + pos, gamma, length);
+    }
+    raw_bytes::secure_zero(gamma, block_lenght);
+}
+
+template <typename CipherType>
+void OFB_Mode<CipherType>::encrypt(SegmentReader & src, SegmentWriter & dst) const {
+    const size_t block_lenght = CipherType::block_lenght;
+    if(dst.remaining() < src.remaining())
+        throw std::length_error("Output segments are shorter than the message");
+
+    BYTE input[block_lenght], output[block_lenght], gamma[block_lenght];
+    memcpy(gamma, iv.byte_ptr(), block_lenght);
+
+    while(src.remaining()) {
+        size_t length = std::min(block_lenght, src.remaining());
+        const BYTE * in = src.read(length, input);
+        BYTE * out = dst.peek(length, output);
+        algorithm.encrypt_block(gamma, gamma);
+        raw_bytes::xor_n(out, in, gamma, length);
+        dst.write(out, length);
+    }
+    raw_bytes::secure_zero(input, block_lenght);
+    raw_bytes::secure_zero(output, block_lenght);
+    raw_bytes::secure_zero(gamma, block_lenght);
+}
+
+template <typename CipherType>
+void OFB_Mode<CipherType>::decrypt(ByteView src, ByteBlock & dst) const {
+	encrypt(src, dst);
+	dst.set_sensitivity(Sensitivity::sensitive);
+}
 
-	algorithm.encrypt(iv, tmp);
-	xor_blocks(blocks[0], blocks[0], tmp);
-	for(int i = 1; i < blocks.size(); i++) {
-		algorithm.encrypt(tmp, tmp);
-		xor_blocks(blocks[i], blocks[i], tmp);
-	}
-	dst = join_blocks(blocks);
+template <typename CipherType>
+void OFB_Mode<CipherType>::decrypt(ByteView src, BYTE * dst) const {
+	encrypt(src, dst);
 }
 
 template <typename CipherType>
-void OFB_Mode<CipherType>::decrypt(const ByteBlock & src, ByteBlock & dst) const {
-	encrypt(src, dst, iv);
+void OFB_Mode<CipherType>::decrypt(SegmentReader & src, SegmentWriter & dst) const {
+	encrypt(src, dst);
 }
 
 /*------------------------- Electronic Code Book Mode ----------------------------*/
@@ -143,21 +266,39 @@ ECB_Mode<CipherType>::ECB_Mode(const CipherType & alg) : algorithm(alg)
 }
 
 template <typename CipherType>
-void ECB_Mode<CipherType>::encrypt(const ByteBlock & src, ByteBlock & dst) const {
+void ECB_Mode<CipherType>::encrypt(ByteView src, ByteBlock & dst) const {
+    if( src.size() % CipherType::block_lenght )
+        throw std::invalid_argument("Msg must be partible on block_lenght");
+
+    ByteBlock holder;
+    BYTE * output = prepare_output(src, dst, holder);
+    encrypt(src, output);
+    dst.set_sensitivity(Sensitivity::nonsensitive);
+}
+
+template <typename CipherType>
+void ECB_Mode<CipherType>::encrypt(ByteView src, BYTE * dst) const {
+    if( src.size() % CipherType::block_lenght )
+        throw std::invalid_argument("Msg must be partible on block_lenght");
+
+    algorithm.encrypt_blocks(src.byte_ptr(), dst, src.size() / CipherType::block_lenght);
+}
+
+template <typename CipherType>
+void ECB_Mode<CipherType>::decrypt(ByteView src, ByteBlock & dst) const {
     if( src.size() % CipherType::block_lenght )
         throw std::invalid_argument("Msg must be partible on block_lenght");
 
-	auto blocks = split_blocks(src, CipherType::block_lenght);
-    for(auto & block : blocks) algorithm.encrypt(block, block);
-    dst = join_blocks(blocks);
+    ByteBlock holder;
+    BYTE * output = prepare_output(src, dst, holder);
+    decrypt(src, output);
+    dst.set_sensitivity(Sensitivity::sensitive);
 }
 
 template <typename CipherType>
-void ECB_Mode<CipherType>::decrypt(const ByteBlock & src, ByteBlock & dst) const {
+void ECB_Mode<CipherType>::decrypt(ByteView src, BYTE * dst) const {
     if( src.size() % CipherType::block_lenght )
         throw std::invalid_argument("Msg must be partible on block_lenght");
 
-    auto blocks = split_blocks(src, CipherType::block_lenght);
-    for(auto & block : blocks) algorithm.decrypt(block, block);
-    dst = join_blocks(blocks);
+    algorithm.decrypt_blocks(src.byte_ptr(), dst, src.size() / CipherType::block_lenght);
 }
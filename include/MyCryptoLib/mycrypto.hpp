@@ -9,9 +9,94 @@ using std::string;
 typedef unsigned char BYTE;
 typedef unsigned short WORD;
 
+class ByteBlock;
+
+// Sensitive blocks (keys, cipher states, plaintext of unknown origin)
+// are wiped before their storage is released or reused.
+// Nonsensitive ones (ciphertext, public payloads) are simply freed
+enum class Sensitivity { sensitive, nonsensitive };
+
+// sensitive_only - wipe only sensitive blocks, the default
+// everything - wipe every block whatever it's tagged with
+enum class WipePolicy { sensitive_only, everything };
+
+// Non-owning view on a contiguous range of bytes. It never allocates
+// or frees memory, so the viewed storage (usually a ByteBlock) must
+// outlive the view. Every ByteBlock converts to the view of its whole body.
+// Small blocks keep their body inside the object, so moving such a block
+// invalidates views on it
+class ByteView {
+    const BYTE * pBlocks;
+    size_t amount_of_bytes;
+public:
+    // Construct empty view
+    ByteView();
+
+    // Construct view on size_ first bytes of pBlocks_
+    ByteView(const BYTE * pBlocks_, size_t size_);
+
+    // Construct view on the whole body of the block
+    ByteView(const ByteBlock & bb);
+
+    const BYTE * byte_ptr() const;
+
+    BYTE operator [] (size_t index) const;
+
+    // Return amount of bytes in view
+    size_t size() const;
+
+    // It'll return a copy of viewed bytes which owns its memory
+    ByteBlock deep_copy() const;
+
+    // It'll return slice of current view, nothing is copied
+    ByteView operator () (size_t begin, size_t length) const;
+};
+
+// Writable counterpart of ByteView, e.g. one of the buffers
+// which output of a scatter-gather call goes to
+class MutableByteView {
+    BYTE * pBlocks;
+    size_t amount_of_bytes;
+public:
+    // Construct view on size_ first bytes of pBlocks_
+    MutableByteView(BYTE * pBlocks_, size_t size_);
+
+    // Construct view on the whole body of the block
+    MutableByteView(ByteBlock & bb);
+
+    BYTE * byte_ptr() const;
+
+    // Return amount of bytes in view
+    size_t size() const;
+};
+
 class ByteBlock {
+public:
+    // Blocks not longer than this are stored inside the object itself,
+    // so cipher blocks, key wrap semiblocks and digests never touch the heap.
+    // Longer ones are taken from and given back to BytePool
+    static const size_t inline_capacity = 64;
+    // Heap bodies always start at this boundary
+    static const size_t cache_line = 64;
+
+private:
 	BYTE * pBlocks;
 	size_t amount_of_bytes;
+	size_t reserved_bytes;
+	bool aligned_body;
+	Sensitivity sensitivity_tag;
+	BYTE inline_storage[inline_capacity];
+
+    // Point pBlocks to storage of at least size_ bytes,
+    // content is undefined
+    void allocate(size_t size_);
+    // Zero and free the current storage, block turns to null
+    void release();
+    // Take the body of rhs, rhs turns to null
+    void steal(ByteBlock & rhs);
+    // Zero n_bytes at ptr if the block and the policy demand it
+    void wipe(BYTE * ptr, size_t n_bytes) const;
+
 public:
     // Construct block of bytes which contsists of
     // size_ blocks each of them with init_value in it
@@ -19,7 +104,16 @@ public:
 
     // Construct block with size_ first bytes of pBlocks_
     // The value will be copied, source stays untouchable
-    ByteBlock(BYTE * pBlocks_, size_t size_);
+    ByteBlock(const BYTE * pBlocks_, size_t size_);
+
+    // Construct block with the content of view
+    // The value will be copied, source stays untouchable
+    explicit ByteBlock(ByteView view);
+
+    // Construct block like ByteBlock(size_, init_value) whose body
+    // starts at cache_line boundary however short it is. The block keeps
+    // this property while it grows through reset, reserve and resize
+    static ByteBlock cache_aligned(size_t size_, BYTE init_value = 0);
 
     // Move constructor
     // Copy constructor thus implicitly deleted
@@ -46,54 +140,183 @@ public:
 	bool operator != (const ByteBlock & lhs) const;
 
     // Replace body of the current block with pBlocks_
-    // Old value will be zerod, and then, deleted
-    // New value copied into the block,
-    // source stays untouchable
+    // New value copied into the block, source stays untouchable
+    // and may even point into the block itself. Current storage is
+    // reused if it's large enough, the bytes left behind are wiped.
+    // Otherwise old value will be wiped, and then, deleted.
+    // Null pBlocks_ gives size_ zero bytes, zero size_ gives null block
     void reset(const BYTE * pBlocks_, size_t size_);
 
     // Return amount of bytes in block
     size_t size() const;
 
+    // Return amount of bytes the block can hold without reallocation
+    size_t capacity() const;
+
+    // Make room for capacity_ bytes, content is kept
+    // Views on the block are invalidated if it has to reallocate
+    void reserve(size_t capacity_);
+
+    // Change size of the block, new bytes are zero, cut ones are wiped
+    // Doesn't reallocate while size_ fits into capacity()
+    void resize(size_t size_);
+
+    // Check if the body stays at cache_line boundary whatever its size
+    bool is_cache_aligned() const;
+
+    // Blocks are sensitive unless told otherwise, the tag goes
+    // along with the body on move and to deep copies
+    void set_sensitivity(Sensitivity tag);
+    Sensitivity sensitivity() const;
+
+    // Global policy of wiping released and cut bytes
+    static void set_wipe_policy(WipePolicy policy);
+    static WipePolicy wipe_policy();
+
     // It'll return deep copy of the block, which
     // points to different place in memory
     ByteBlock deep_copy() const;
 
 	// It'll return slice of current ByteBlock
-    ByteBlock operator () (size_t begin, size_t length) const;
+	// The slice points into the block, nothing is copied
+    ByteView operator () (size_t begin, size_t length) const;
 
 	// Changes values between two ByteBlock-s
 	friend void swap(ByteBlock & lhs, ByteBlock & rhs);
-	// Check if two ByteBlock have equivalent content
-	friend bool equal(ByteBlock const & lhs, ByteBlock const & rhs);
 };
 
+// Check if two ranges of bytes have equivalent content
+bool equal(ByteView lhs, ByteView rhs);
+
+// Check if two ranges of bytes share some memory
+bool overlap(ByteView lhs, ByteView rhs);
+
 // Some functions which will be useful for implementation of encryption algorithms
-std::vector<ByteBlock> split_blocks(const ByteBlock & src, size_t length);
+std::vector<ByteBlock> split_blocks(ByteView src, size_t length);
 ByteBlock join_blocks(const std::vector<ByteBlock> & blocks);
-void xor_blocks(ByteBlock & to_assign, const ByteBlock & lhs, const ByteBlock & rhs);
+// Same as above but reuses storage of dst when it's large enough
+void join_blocks(const std::vector<ByteBlock> & blocks, ByteBlock & dst);
+// to_assign = lhs ^ rhs cut to the shorter of them. When lhs or rhs is
+// to_assign itself the result is computed in place, otherwise
+// the storage of to_assign is reused if it's large enough
+void xor_blocks(ByteBlock & to_assign, ByteView lhs, ByteView rhs);
+// Resize dst to take src.size() bytes of output computed from src and
+// return where to write them. If src lies inside dst but not at its
+// beginning, it's copied to holder first and src is pointed there
+BYTE * prepare_output(ByteView & src, ByteBlock & dst, ByteBlock & holder);
+
+// Message scattered over a chain of segments (packet buffers and so on)
+// is read and written with these cursors. Blocks of a cipher or a hash
+// may span segment edges, only those are gathered into a buffer.
+// Segments aren't owned, so they must outlive the cursor
+class SegmentReader {
+    const ByteView * segments;
+    size_t n_segments;
+    size_t index;           // current segment
+    size_t segment_start;   // position of its first byte in the message
+    size_t position;
+    size_t total;
+public:
+    SegmentReader(const ByteView * segments_, size_t n_segments_);
+    SegmentReader(const std::vector<ByteView> & segments_);
+
+    // Amount of bytes in all segments and amount of them not read yet
+    size_t size() const;
+    size_t remaining() const;
+
+    // Return pointer to the next n_bytes and step over them. It points
+    // into the segment when they lie in one, otherwise they are copied
+    // to buffer which must have room for n_bytes
+    const BYTE * read(size_t n_bytes, BYTE * buffer);
+
+    // Move to any position in the message, e.g. to walk it backwards
+    void seek(size_t position_);
+};
+
+class SegmentWriter {
+    const MutableByteView * segments;
+    size_t n_segments;
+    size_t index;
+    size_t offset;          // position inside the current segment
+    size_t left;
+public:
+    SegmentWriter(const MutableByteView * segments_, size_t n_segments_);
+    SegmentWriter(const std::vector<MutableByteView> & segments_);
+
+    // Amount of bytes which can still be written
+    size_t remaining() const;
+
+    // Return where to put the next n_bytes: into the segment
+    // when they fit in one, to buffer otherwise
+    BYTE * peek(size_t n_bytes, BYTE * buffer);
+
+    // Store n_bytes of data and step over them. Data placed
+    // where peek pointed to is not copied once again
+    void write(const BYTE * data, size_t n_bytes);
+};
 
 // Some I/O functions to work with hex representation of ByteBlock
-string hex_representation(const ByteBlock & bb);
-ByteBlock hex_to_bytes(const string & s);
-ByteBlock hex_to_bytes(char const * s, unsigned length);
+// They are table driven and use SSSE3/AVX2 when the CPU has it
+string hex_representation(ByteView bb);
+ByteBlock hex_to_bytes(const string & s, Sensitivity tag = Sensitivity::sensitive);
+ByteBlock hex_to_bytes(char const * s, unsigned length, Sensitivity tag = Sensitivity::sensitive);
+
+// The same, but write into dst reusing its storage
+void hex_representation(ByteView bb, string & dst);
+void hex_to_bytes(char const * s, size_t length, ByteBlock & dst);
+
+// Write 2 * bb.size() hex digits to dst, no terminating zero is added.
+// Every byte is encoded on its own, so a long message may be
+// encoded chunk by chunk
+void hex_encode(ByteView bb, char * dst);
+
+// Decoder of hex string which comes chunk by chunk.
+// A chunk may end in the middle of a byte
+class HexDecoder {
+    int pending_nibble;
+public:
+    HexDecoder();
+
+    // Decode length digits of s to dst and return amount of bytes written,
+    // dst must have room for (length + 1) / 2 bytes
+    size_t update(char const * s, size_t length, BYTE * dst);
+
+    // Throw if the digits fed so far don't make whole bytes
+    void finish();
+};
 
 // Template class that provides implementation of Cipher Feadback mode
 // of operation with any block cipher (algorithm) which saticfy several
 // requirement. It must have got:
-// copy constructor, methods encrypt and decrypt with the same interface
+// copy constructor, methods encrypt and decrypt with the same interface,
+// noexcept encrypt_block and decrypt_block of one raw block,
+// encrypt_blocks and decrypt_blocks over a run of raw blocks
 // and public member-data block_lenght
+// Every mode tags the output of encrypt as nonsensitive
+// and the output of decrypt as sensitive.
+// Modes run over the message in one pass without splitting it. Overloads
+// with BYTE * dst write src.size() bytes there, dst may be equal to
+// src.byte_ptr() or lie apart from src.
+// Overloads with segment cursors process all that's left in src and
+// throw std::length_error if dst has less room. The chain of dst segments
+// may be the one of src, or cover another memory
 template <typename CipherType>
 class CFB_Mode {
     const CipherType algorithm;
     const ByteBlock iv;
 
-	void decrypt_with_iv(const ByteBlock & src, ByteBlock & dst, const ByteBlock & iv_) const;
+	void decrypt_with_iv(ByteView src, BYTE * dst, ByteView iv_) const;
 public:
-    CFB_Mode(const CipherType & alg, const ByteBlock & init_vec);
-    void encrypt(const ByteBlock & src, ByteBlock & dst) const;
-    void decrypt(const ByteBlock & src, ByteBlock & dst) const;
+    CFB_Mode(const CipherType & alg, ByteView init_vec);
+    void encrypt(ByteView src, ByteBlock & dst) const;
+    void decrypt(ByteView src, ByteBlock & dst) const;
+    void encrypt(ByteView src, BYTE * dst) const;
+    void decrypt(ByteView src, BYTE * dst) const;
+    void encrypt(SegmentReader & src, SegmentWriter & dst) const;
+    void decrypt(SegmentReader & src, SegmentWriter & dst) const;
 
-	void parallel_decrypt(const ByteBlock & src, ByteBlock & dst) const;
+	void parallel_decrypt(ByteView src, ByteBlock & dst) const;
+	void parallel_decrypt(ByteView src, BYTE * dst) const;
 };
 
 template <typename CipherType>
@@ -102,9 +325,13 @@ class OFB_Mode {
 	const ByteBlock iv;
 
 public:
-	OFB_Mode(const CipherType & alg, const ByteBlock & iniv_vec);
-	void encrypt(const ByteBlock & src, ByteBlock & dst) const;
-	void decrypt(const ByteBlock & src, ByteBlock & dst) const;
+	OFB_Mode(const CipherType & alg, ByteView iniv_vec);
+	void encrypt(ByteView src, ByteBlock & dst) const;
+	void decrypt(ByteView src, ByteBlock & dst) const;
+	void encrypt(ByteView src, BYTE * dst) const;
+	void decrypt(ByteView src, BYTE * dst) const;
+	void encrypt(SegmentReader & src, SegmentWriter & dst) const;
+	void decrypt(SegmentReader & src, SegmentWriter & dst) const;
 };
 
 template <typename CipherType>
@@ -113,8 +340,10 @@ class ECB_Mode {
 
 public:
 	ECB_Mode(const CipherType & alg);
-	void encrypt(const ByteBlock & src, ByteBlock & dst) const;
-	void decrypt(const ByteBlock & src, ByteBlock & dst) const;
+	void encrypt(ByteView src, ByteBlock & dst) const;
+	void decrypt(ByteView src, ByteBlock & dst) const;
+	void encrypt(ByteView src, BYTE * dst) const;
+	void decrypt(ByteView src, BYTE * dst) const;
 };
 
 // Implementations of modes of encryption
@@ -3,6 +3,7 @@ using std::tuple;
 using std::pair;
 
 #include <cstdint>
+#include <cstddef>
 
 #ifndef __RAWBYTES__
 #define __RAWBYTES__
@@ -17,7 +18,16 @@ typedef uint32_t dword;
 typedef uint64_t qword;
 
 // it'll xor n_bytes relevant lhs's ans rhs's bytes and place result at dst
-void xor_n(byte * dst, const byte * lhs, const byte * rhs, unsigned int n_bytes);
+// dst may coincide with lhs or rhs, but mustn't overlap them partially.
+// Bytes go by 64-bit words, by SSE2 or AVX2 registers when the CPU has
+// them, no alignment is required
+void xor_n(byte * dst, const byte * lhs, const byte * rhs, size_t n_bytes);
+
+// dst ^= src on n_bytes, the same restrictions as above
+void xor_inplace(byte * dst, const byte * src, size_t n_bytes);
+
+// it'll zero n_bytes at dst, the compiler can't drop it as a dead store
+void secure_zero(byte * dst, size_t n_bytes);
 
 // position's counting starts with 1
 // zero means there isn't any nonzero bits
@@ -25,6 +35,7 @@ short nonzero_msb(word number);
 
 // considered deg(lhs) + deg(rhs) < 16
 word multiply_poly(word lhs, word rhs);
+// moduli of GaloisField go through its tables
 word multiply_field(word lhs, word rhs, word modulus);
 
 // considered deg(base) < 8
@@ -40,6 +51,46 @@ std::tuple<word, word, word> ext_gcd_poly(word a, word b);
 // if a is zero then return zero
 byte inverse_poly(byte a, word modulus);
 
+// Tables of GF(2^8) = GF(2)[x] / modulus: exp holds powers of the least
+// generator of the multiplicative group, twice over so sums of two
+// logarithms need no reduction, log is the inverse of it (log[0] unused),
+// product[a].by[b] is a * b
+struct FieldTables {
+    struct Products { byte by[256]; };
+
+    byte exp[512];
+    byte log[256];
+    Products product[256];
+};
+
+// Arithmetic of GF(2^8) in O(1) lookups, for the moduli of the ciphers:
+// 0x11B of Rijndael and 0x1C3 of Kuznyechik. The tables are computed
+// by the compiler and lie in read-only data
+template <word Modulus>
+class GaloisField {
+    static const FieldTables tables;
+public:
+    // one lookup in 64 KB of products
+    static byte multiply(byte lhs, byte rhs) {
+        return tables.product[lhs].by[rhs];
+    }
+    // through logarithms, less than 1 KB of tables to keep in cache
+    static byte multiply_log(byte lhs, byte rhs) {
+        return lhs && rhs ? tables.exp[tables.log[lhs] + tables.log[rhs]] : 0;
+    }
+    static byte power(byte base, unsigned p) {
+        if(!p) return 1;
+        return base ? tables.exp[tables.log[base] * (p % 255) % 255] : 0;
+    }
+    // zero is left zero
+    static byte inverse(byte a) {
+        return a ? tables.exp[255 - tables.log[a]] : 0;
+    }
+};
+
+template <> const FieldTables GaloisField<0x11B>::tables;
+template <> const FieldTables GaloisField<0x1C3>::tables;
+
 // it'll reject bits at positions > 16
 short sum_of_bits(word target);
 
@@ -5,7 +5,10 @@
 class SHA256 {
     static unsigned        const    _hash_length { 32 };
 public:
-    void hash(ByteBlock const & src, ByteBlock & dst) const;
+    void hash(ByteView src, ByteBlock & dst) const;
+    // Hash all that's left in src, the message may be scattered
+    // over many segments
+    void hash(SegmentReader & src, ByteBlock & dst) const;
 };
 
 void padding(BYTE * ptr, unsigned tail_size, unsigned buf_size, unsigned msg_size);
@@ -1,4 +1,31 @@
+#include <cstddef>
+
+#ifndef __USEFUL__
+#define __USEFUL__
+
 template <typename T>
 inline T & make_rw(const T & target) {
     return const_cast<T>(target);
 }
+
+// Indices<0, 1, ..., N - 1> to expand into initializers of tables
+// the compiler computes entry by entry
+template <size_t... I> struct Indices {};
+
+template <typename Lhs, typename Rhs> struct ConcatIndices;
+template <size_t... I, size_t... J>
+struct ConcatIndices< Indices<I...>, Indices<J...> > {
+	typedef Indices<I..., (sizeof...(I) + J)...> type;
+};
+
+// built by halves to keep recursion shallow
+template <size_t N> struct MakeIndices {
+	typedef typename ConcatIndices<
+		typename MakeIndices<N / 2>::type,
+		typename MakeIndices<N - N / 2>::type
+	>::type type;
+};
+template <> struct MakeIndices<0> { typedef Indices<> type; };
+template <> struct MakeIndices<1> { typedef Indices<0> type; };
+
+#endif
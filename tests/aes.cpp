@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <MyCryptoLib/Rijndael.hpp>
+
+static const char * KEY =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f";
+static const char * PT = "00112233445566778899aabbccddeeff";
+
+static const AesEngine ENGINES[] = {
+    AesEngine::tables,
+    AesEngine::aesni,
+    AesEngine::bitsliced
+};
+
+template <typename Cipher>
+static void check_vector(ByteView key, const char * expected) {
+    for(auto engine : ENGINES) {
+        Cipher cipher(key, engine);
+        ByteBlock pt = hex_to_bytes(PT), ct, result;
+
+        cipher.encrypt(pt, ct);
+        ASSERT_EQ(hex_representation(ct), expected);
+        cipher.decrypt(ct, result);
+        ASSERT_TRUE(equal(result, pt));
+
+        // raw blocks, in place
+        uint8_t block[16];
+        cipher.encrypt_block(pt.byte_ptr(), block);
+        ASSERT_EQ(hex_representation(ByteView(block, 16)), expected);
+        cipher.decrypt_block(block, block);
+        ASSERT_TRUE(equal(ByteView(block, 16), pt));
+    }
+}
+
+// FIPS 197, C.1 - C.3
+TEST(AESTest, StandardVectors) {
+    ByteBlock key = hex_to_bytes(KEY);
+    check_vector<AES128>(key(0, 16), "69c4e0d86a7b0430d8cdb78070b4c55a");
+    check_vector<AES192>(key(0, 24), "dda97ca4864cdfe06eaf70a0ec0d7191");
+    check_vector<AES256>(key, "8ea2b7ca516745bfeafc49904b496089");
+}
+
+template <typename Cipher>
+static void check_engines_agree(size_t key_size) {
+    ByteBlock key(key_size), blocks(16 * 19), expected(blocks.size()), result(blocks.size());
+    for(int n_test = 0; n_test < 50; n_test++) {
+        for(size_t i = 0; i < key.size(); i++) key[i] = rand();
+        for(size_t i = 0; i < blocks.size(); i++) blocks[i] = rand();
+
+        Cipher reference(key, AesEngine::tables);
+        for(auto engine : ENGINES) {
+            Cipher cipher(key, engine);
+            // counts below, at and above the groups the engines interleave
+            for(size_t n_blocks : {1, 4, 7, 8, 19}) {
+                size_t length = 16 * n_blocks;
+                reference.encrypt_blocks(blocks.byte_ptr(), expected.byte_ptr(), n_blocks);
+                cipher.encrypt_blocks(blocks.byte_ptr(), result.byte_ptr(), n_blocks);
+                ASSERT_TRUE(equal(result(0, length), expected(0, length)));
+
+                // in place
+                cipher.decrypt_blocks(result.byte_ptr(), result.byte_ptr(), n_blocks);
+                ASSERT_TRUE(equal(result(0, length), blocks(0, length)));
+            }
+        }
+    }
+}
+
+TEST(AESTest, EnginesAgree) {
+    srand(26112001);
+    check_engines_agree<AES128>(16);
+    check_engines_agree<AES192>(24);
+    check_engines_agree<AES256>(32);
+}
+
+// Keys to decrypt with are made on the first decryption, by whichever
+// thread comes first, and copies get them whenever they were made
+TEST(AESTest, LazyDecryption) {
+    ByteBlock key = hex_to_bytes(KEY), pt = hex_to_bytes(PT);
+    for(auto engine : ENGINES) {
+        AES256 cipher(key, engine);
+        AES256 before(cipher);
+        ByteBlock ct;
+        cipher.encrypt(pt, ct);
+
+        // half of the threads decrypt, the others copy the cipher
+        // while its decryption keys are being made
+        std::vector<std::thread> threads;
+        std::vector<char> agree(8, 0);
+        std::atomic<bool> go(false);
+        for(size_t i = 0; i < agree.size(); i++) {
+            threads.emplace_back([&, i]() {
+                ByteBlock result;
+                while(!go) std::this_thread::yield();
+                if(i % 2) {
+                    cipher.decrypt(ct, result);
+                } else {
+                    AES256 copy(cipher);
+                    copy.decrypt(ct, result);
+                }
+                agree[i] = equal(result, pt);
+            });
+        }
+        go = true;
+        for(auto & thread : threads) thread.join();
+        for(char ok : agree) ASSERT_TRUE(ok);
+
+        AES256 after(cipher);
+        ByteBlock result;
+        before.decrypt(ct, result);
+        ASSERT_TRUE(equal(result, pt));
+        after.decrypt(ct, result);
+        ASSERT_TRUE(equal(result, pt));
+
+        // the raw primitive makes the keys by itself
+        AES256 fresh(key, engine);
+        uint8_t block[16];
+        fresh.decrypt_block(ct.byte_ptr(), block);
+        ASSERT_TRUE(equal(ByteView(block, 16), pt));
+
+        AES256 eager(key, engine);
+        eager.prepare_decryption();
+        eager.decrypt(ct, result);
+        ASSERT_TRUE(equal(result, pt));
+    }
+}
@@ -0,0 +1,378 @@
+#include <gtest/gtest.h>
+#include <MyCryptoLib/mycrypto.hpp>
+#include <MyCryptoLib/bytepool.hpp>
+#include <MyCryptoLib/bytestats.hpp>
+#include <MyCryptoLib/Rijndael.hpp>
+#include <MyCryptoLib/rawbytes.hpp>
+
+TEST(ByteViewTest, SliceDoesNotCopy) {
+    ByteBlock block = hex_to_bytes("00112233445566778899aabbccddeeff");
+    ByteView slice = block(4, 8);
+
+    ASSERT_EQ(slice.size(), 8u);
+    ASSERT_EQ(slice.byte_ptr(), block.byte_ptr() + 4);
+    ASSERT_EQ(hex_representation(slice), "445566778899aabb");
+
+    ByteView inner = slice(2, 4);
+    ASSERT_EQ(inner.byte_ptr(), block.byte_ptr() + 6);
+    ASSERT_EQ(hex_representation(inner), "66778899");
+}
+
+TEST(ByteViewTest, DeepCopyOwnsMemory) {
+    ByteBlock block = hex_to_bytes("0011223344556677");
+    ByteBlock copy(block(2, 4));
+
+    ASSERT_NE(copy.byte_ptr(), block.byte_ptr() + 2);
+    ASSERT_TRUE(equal(copy, block(2, 4)));
+
+    block[2] = 0xff;
+    ASSERT_EQ(hex_representation(copy), "22334455");
+}
+
+TEST(ByteViewTest, SelfSliceAssignment) {
+    ByteBlock block = hex_to_bytes("0011223344556677");
+    block = ByteBlock(block(6, 2));
+    ASSERT_EQ(hex_representation(block), "6677");
+}
+
+TEST(ByteBlockTest, SmallBlocksAreInline) {
+    ByteBlock block(ByteBlock::inline_capacity, 0xaa);
+    const BYTE * object_begin = reinterpret_cast<const BYTE *>(&block);
+    const BYTE * object_end = object_begin + sizeof block;
+
+    ASSERT_TRUE(block.byte_ptr() >= object_begin && block.byte_ptr() < object_end);
+
+    ByteBlock big(ByteBlock::inline_capacity + 1, 0xbb);
+    ASSERT_FALSE(big.byte_ptr() >= object_begin && big.byte_ptr() < object_end);
+}
+
+TEST(ByteBlockTest, MoveKeepsContent) {
+    ByteBlock small = hex_to_bytes("00112233445566778899aabbccddeeff");
+    ByteBlock big(100, 0x5a);
+
+    ByteBlock moved(std::move(small));
+    ASSERT_EQ(small.size(), 0u);
+    ASSERT_EQ(hex_representation(moved), "00112233445566778899aabbccddeeff");
+
+    swap(moved, big);
+    ASSERT_EQ(moved.size(), 100u);
+    ASSERT_EQ(moved[99], 0x5a);
+    ASSERT_EQ(hex_representation(big), "00112233445566778899aabbccddeeff");
+
+    std::vector<ByteBlock> blocks;
+    for(int i = 0; i < 100; i++) blocks.push_back(ByteBlock(16, i));
+    for(int i = 0; i < 100; i++) ASSERT_EQ(blocks[i][15], i);
+}
+
+TEST(BytePoolTest, RecyclesWipedBuffers) {
+    BytePool::set_enabled(true);
+    BytePool::trim();
+    BytePool::reset_statistics();
+
+    const BYTE * first_body;
+    {
+        ByteBlock block(200, 0xcc);
+        first_body = block.byte_ptr();
+    }
+    ASSERT_EQ(BytePool::statistics().misses, 1u);
+    ASSERT_EQ(BytePool::statistics().bytes_held, 256u);
+
+    ByteBlock block(130);
+    ASSERT_EQ(block.byte_ptr(), first_body);
+    ASSERT_EQ(BytePool::statistics().hits, 1u);
+    ASSERT_EQ(BytePool::statistics().bytes_held, 0u);
+    for(size_t i = 0; i < block.size(); i++) ASSERT_EQ(block[i], 0);
+}
+
+TEST(BytePoolTest, DisabledPoolKeepsNothing) {
+    BytePool::set_enabled(false);
+    BytePool::reset_statistics();
+    {
+        ByteBlock block(1000);
+    }
+    ByteBlock block(1000);
+    BytePoolStats stats = BytePool::statistics();
+    BytePool::set_enabled(true);
+
+    ASSERT_EQ(stats.hits, 0u);
+    ASSERT_EQ(stats.misses, 2u);
+}
+
+TEST(ByteBlockTest, ResizeWithinCapacityKeepsStorage) {
+    ByteBlock block(100, 0x11);
+    const BYTE * body = block.byte_ptr();
+    ASSERT_GE(block.capacity(), 100u);
+
+    block.resize(10);
+    ASSERT_EQ(block.byte_ptr(), body);
+    ASSERT_EQ(body[10], 0);
+
+    block.resize(block.capacity());
+    ASSERT_EQ(block.byte_ptr(), body);
+    ASSERT_EQ(block[9], 0x11);
+    ASSERT_EQ(block[10], 0);
+
+    block.reserve(1000);
+    ASSERT_GE(block.capacity(), 1000u);
+    ASSERT_EQ(block[9], 0x11);
+
+    body = block.byte_ptr();
+    block.reset(block.byte_ptr() + 5, 500);
+    ASSERT_EQ(block.byte_ptr(), body);
+    ASSERT_EQ(block[0], 0x11);
+    ASSERT_EQ(block[4], 0x11);
+    ASSERT_EQ(block[5], 0);
+}
+
+TEST(ByteBlockTest, CacheAlignedBodies) {
+    ByteBlock block = ByteBlock::cache_aligned(16);
+    ASSERT_TRUE(block.is_cache_aligned());
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(block.byte_ptr()) % ByteBlock::cache_line, 0u);
+
+    block.resize(5000);
+    ASSERT_TRUE(block.is_cache_aligned());
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(block.byte_ptr()) % ByteBlock::cache_line, 0u);
+
+    ByteBlock big(100000);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(big.byte_ptr()) % ByteBlock::cache_line, 0u);
+}
+
+TEST(ByteBlockTest, ReusedOutputKeepsStorage) {
+    ByteBlock key(32, 0x42), iv(16, 0x24), msg(1000, 0x33), dst;
+    CFB_Mode<AES128> cfb(AES128(key(0, 16)), iv);
+
+    cfb.encrypt(msg, dst);
+    const BYTE * body = dst.byte_ptr();
+    BytePool::set_enabled(false);
+    BytePool::reset_statistics();
+    cfb.encrypt(msg, dst);
+    BytePoolStats stats = BytePool::statistics();
+    BytePool::set_enabled(true);
+
+    ASSERT_EQ(stats.misses, 0u);
+    ASSERT_EQ(dst.byte_ptr(), body);
+    ASSERT_EQ(dst.size(), msg.size());
+}
+
+TEST(ByteBlockTest, OnlySensitiveBlocksAreWiped) {
+    BytePool::set_enabled(true);
+    BytePool::trim();
+
+    {
+        ByteBlock block(200, 0xcc);
+        block.set_sensitivity(Sensitivity::nonsensitive);
+    }
+    BYTE * body = BytePool::acquire(200);
+    ASSERT_EQ(body[100], 0xcc);
+    BytePool::recycle(body, 200);
+
+    {
+        ByteBlock block(200, 0xcc);
+        ASSERT_EQ(block.byte_ptr(), body);
+        ASSERT_TRUE(block.sensitivity() == Sensitivity::sensitive);
+    }
+    body = BytePool::acquire(200);
+    ASSERT_EQ(body[100], 0);
+    BytePool::recycle(body, 200);
+
+    ByteBlock::set_wipe_policy(WipePolicy::everything);
+    {
+        ByteBlock block(200, 0xcc);
+        block.set_sensitivity(Sensitivity::nonsensitive);
+    }
+    ByteBlock::set_wipe_policy(WipePolicy::sensitive_only);
+    body = BytePool::acquire(200);
+    ASSERT_EQ(body[100], 0);
+    BytePool::recycle(body, 200);
+}
+
+TEST(XorTest, KernelsMatchBytewiseXor) {
+    ByteBlock lhs(300), rhs(300), dst(300);
+    for(size_t i = 0; i < 300; i++) {
+        lhs[i] = i * 7 + 1;
+        rhs[i] = i * 13 + 5;
+    }
+
+    for(size_t offset = 0; offset < 3; offset++) {
+        for(size_t length = 0; length + offset <= 300; length += 17) {
+            raw_bytes::xor_n(dst.byte_ptr(), lhs.byte_ptr() + offset, rhs.byte_ptr(), length);
+            for(size_t i = 0; i < length; i++)
+                ASSERT_EQ(dst[i], lhs[i + offset] ^ rhs[i]);
+        }
+    }
+
+    ByteBlock copy = lhs.deep_copy();
+    raw_bytes::xor_inplace(copy.byte_ptr() + 1, rhs.byte_ptr(), 299);
+    ASSERT_EQ(copy[0], lhs[0]);
+    for(size_t i = 1; i < 300; i++) ASSERT_EQ(copy[i], lhs[i] ^ rhs[i - 1]);
+}
+
+TEST(XorTest, XorBlocksInPlace) {
+    ByteBlock block = hex_to_bytes("00112233445566778899aabbccddeeff00");
+    ByteBlock mask = hex_to_bytes("ffffffffffffffffffffffffffffffff");
+    const BYTE * body = block.byte_ptr();
+
+    xor_blocks(block, block, mask);
+    ASSERT_EQ(block.byte_ptr(), body);
+    ASSERT_EQ(hex_representation(block), "ffeeddccbbaa99887766554433221100");
+
+    xor_blocks(block, mask, block);
+    ASSERT_EQ(block.byte_ptr(), body);
+    ASSERT_EQ(hex_representation(block), "00112233445566778899aabbccddeeff");
+
+    xor_blocks(block, block(8, 8), mask);
+    ASSERT_EQ(hex_representation(block), "7766554433221100");
+}
+
+TEST(HexTest, RoundTripAllLengths) {
+    ByteBlock data(300);
+    for(size_t i = 0; i < data.size(); i++) data[i] = i * 151 + 3;
+
+    string hex;
+    ByteBlock decoded;
+    for(size_t length = 0; length <= data.size(); length++) {
+        hex_representation(data(0, length), hex);
+        ASSERT_EQ(hex.size(), 2 * length);
+        for(size_t i = 0; i < length; i++) {
+            ASSERT_EQ(hex[2 * i], "0123456789abcdef"[data[i] >> 4]);
+            ASSERT_EQ(hex[2 * i + 1], "0123456789abcdef"[data[i] & 0xF]);
+        }
+
+        hex_to_bytes(hex.c_str(), hex.size(), decoded);
+        ASSERT_TRUE(equal(decoded, data(0, length)));
+    }
+
+    ASSERT_EQ(hex_representation(hex_to_bytes("00FFaBcD")), "00ffabcd");
+}
+
+TEST(HexTest, BadDigitsAreRejected) {
+    string hex(256, 'a');
+    for(size_t pos : {0, 31, 63, 64, 200, 255}) {
+        for(char bad : {'g', 'G', '/', ':', '@', '`', ' ', '\xc1'}) {
+            string broken = hex;
+            broken[pos] = bad;
+            ASSERT_THROW(hex_to_bytes(broken), std::invalid_argument);
+        }
+    }
+    ASSERT_THROW(hex_to_bytes("abc"), std::invalid_argument);
+}
+
+TEST(HexTest, StreamingDecoder) {
+    string hex = "00112233445566778899aabbccddeeff0123456789abcdef";
+    for(size_t chunk = 1; chunk <= hex.size(); chunk++) {
+        HexDecoder decoder;
+        BYTE out[32];
+        size_t written = 0;
+        for(size_t pos = 0; pos < hex.size(); pos += chunk) {
+            size_t length = std::min(chunk, hex.size() - pos);
+            written += decoder.update(hex.c_str() + pos, length, out + written);
+        }
+        decoder.finish();
+        ASSERT_EQ(hex_representation(ByteView(out, written)), hex);
+    }
+
+    HexDecoder decoder;
+    BYTE out[2];
+    decoder.update("abc", 3, out);
+    ASSERT_THROW(decoder.finish(), std::invalid_argument);
+}
+
+TEST(SegmentTest, ReaderGathersOnlyAcrossEdges) {
+    ByteBlock bb(40);
+    for(size_t i = 0; i < bb.size(); i++) bb[i] = i;
+    std::vector<ByteView> segments = { ByteView(), bb(0, 10), bb(10, 0), bb(10, 30) };
+    SegmentReader reader(segments);
+    BYTE buffer[16];
+
+    ASSERT_EQ(reader.size(), 40);
+    ASSERT_EQ(reader.read(4, buffer), bb.byte_ptr());
+    const BYTE * spanned = reader.read(8, buffer);
+    ASSERT_EQ(spanned, buffer);
+    ASSERT_TRUE(equal(ByteView(spanned, 8), bb(4, 8)));
+    ASSERT_EQ(reader.read(16, buffer), bb.byte_ptr() + 12);
+
+    reader.seek(6);
+    ASSERT_TRUE(equal(ByteView(reader.read(16, buffer), 16), bb(6, 16)));
+    reader.seek(40);
+    ASSERT_EQ(reader.remaining(), 0);
+    ASSERT_THROW(reader.read(1, buffer), std::length_error);
+}
+
+TEST(SegmentTest, WriterScattersOnlyAcrossEdges) {
+    ByteBlock first(5), second(0), third(20), data(25, 0xab);
+    std::vector<MutableByteView> segments = { first, second, third };
+    SegmentWriter writer(segments);
+    BYTE buffer[16];
+
+    ASSERT_EQ(writer.peek(3, buffer), first.byte_ptr());
+    writer.write(data.byte_ptr(), 3);
+    ASSERT_EQ(writer.peek(4, buffer), buffer);
+    writer.write(data.byte_ptr(), 4);
+    ASSERT_EQ(writer.peek(18, buffer), third.byte_ptr() + 2);
+    writer.write(data.byte_ptr(), 18);
+    ASSERT_EQ(writer.remaining(), 0);
+    ASSERT_TRUE(equal(first, data(0, 5)));
+    ASSERT_TRUE(equal(third, data(0, 20)));
+    ASSERT_THROW(writer.write(data.byte_ptr(), 1), std::length_error);
+}
+
+TEST(ByteStatsTest, CountsAllocationsCopiesAndWipes) {
+    bool was_enabled = ByteStats::enabled();
+    ByteStats::set_enabled(true);
+    ByteStats::reset();
+    {
+        ByteBlock big(1000, 1);
+        ByteBlock copy = big.deep_copy();
+        ByteBlock small(16);
+
+        ByteCounters counters = ByteStats::this_thread();
+        ASSERT_EQ(counters.allocations, 2);
+        ASSERT_EQ(counters.bytes_allocated, 2 * BytePool::capacity_for(1000));
+        ASSERT_EQ(counters.deep_copies, 1);
+        ASSERT_EQ(counters.bytes_copied, 1000);
+        ASSERT_EQ(counters.live_bytes, counters.bytes_allocated);
+        ASSERT_EQ(counters.wipes, 0);
+    }
+    ByteCounters counters = ByteStats::this_thread();
+    ASSERT_EQ(counters.live_bytes, 0);
+    ASSERT_EQ(counters.peak_live_bytes, counters.bytes_allocated);
+    ASSERT_EQ(counters.wipes, 3);
+    ASSERT_EQ(counters.bytes_wiped, 2016);
+    ASSERT_GE(ByteStats::global().allocations, 2);
+
+    ByteStats::set_enabled(false);
+    ByteBlock unseen(1000);
+    ASSERT_EQ(ByteStats::this_thread().allocations, 2);
+    ByteStats::set_enabled(was_enabled);
+}
+
+template <raw_bytes::word Modulus>
+static void check_field() {
+    typedef raw_bytes::GaloisField<Modulus> Field;
+    for(unsigned a = 0; a < 256; a++) {
+        for(unsigned b = 0; b < 256; b++) {
+            raw_bytes::word expected =
+                raw_bytes::divide_poly(raw_bytes::multiply_poly(a, b), Modulus).second;
+            ASSERT_EQ(Field::multiply(a, b), expected);
+            ASSERT_EQ(Field::multiply_log(a, b), expected);
+        }
+        if(a) {
+            ASSERT_EQ(Field::multiply(a, Field::inverse(a)), 1);
+        }
+
+        raw_bytes::word power = 1;
+        for(unsigned p = 0; p < 600; p++) {
+            ASSERT_EQ(Field::power(a, p), power);
+            power = Field::multiply(power, a);
+        }
+    }
+    ASSERT_EQ(Field::inverse(0), 0);
+}
+
+TEST(FieldTest, TablesMatchPolynomials) {
+    check_field<0x11B>();
+    check_field<0x1C3>();
+    // FIPS-197, 4.2
+    ASSERT_EQ(raw_bytes::GaloisField<0x11B>::multiply(0x57, 0x83), 0xc1);
+    ASSERT_EQ(raw_bytes::multiply_field(0x57, 0x13, 0x11B), 0xfe);
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <MyCryptoLib/Kuznyechik.hpp>
+#include <MyCryptoLib/bytestats.hpp>
+
+static const char * KEY =
+    "8899aabbccddeeff0011223344556677fedcba98765432100123456789abcdef";
+
+static const Kuznyechik::Engine ENGINES[] = {
+    Kuznyechik::Engine::reference,
+    Kuznyechik::Engine::lookup,
+    Kuznyechik::Engine::compact,
+    Kuznyechik::Engine::simd,
+    Kuznyechik::Engine::constant_time
+};
+
+// GOST R 34.12-2015, A.1
+TEST(KuznyechikTest, StandardVector) {
+    for(auto engine : ENGINES) {
+        Kuznyechik cipher(hex_to_bytes(KEY), engine);
+        ByteBlock pt = hex_to_bytes("1122334455667700ffeeddccbbaa9988");
+        ByteBlock ct, result;
+
+        cipher.encrypt(pt, ct);
+        ASSERT_EQ(hex_representation(ct), "7f679d90bebc24305a468d42b9d4edcd");
+        cipher.decrypt(ct, result);
+        ASSERT_TRUE(equal(result, pt));
+    }
+}
+
+TEST(KuznyechikTest, EnginesAgree) {
+    srand(34122015);
+    ByteBlock key(32), block(16), expected, result;
+    for(int n_test = 0; n_test < 200; n_test++) {
+        for(size_t i = 0; i < key.size(); i++) key[i] = rand();
+        for(size_t i = 0; i < block.size(); i++) block[i] = rand();
+
+        Kuznyechik reference(key, Kuznyechik::Engine::reference);
+        for(auto engine : ENGINES) {
+            Kuznyechik cipher(key, engine);
+            reference.encrypt(block, expected);
+            cipher.encrypt(block, result);
+            ASSERT_TRUE(equal(result, expected));
+
+            reference.decrypt(block, expected);
+            cipher.decrypt(block, result);
+            ASSERT_TRUE(equal(result, expected));
+        }
+    }
+}
+
+TEST(KuznyechikTest, Blocks) {
+    srand(34132015);
+    ByteBlock key(32), blocks(16 * 11), expected(blocks.size()), result(blocks.size());
+    for(size_t i = 0; i < key.size(); i++) key[i] = rand();
+    for(size_t i = 0; i < blocks.size(); i++) blocks[i] = rand();
+
+    for(auto engine : ENGINES) {
+        Kuznyechik cipher(key, engine);
+        // counts below, at and above the groups the engines interleave
+        for(size_t n_blocks : {0, 1, 3, 4, 5, 8, 11}) {
+            ByteBlock block;
+            for(size_t i = 0; i < n_blocks; i++) {
+                cipher.encrypt(blocks(16 * i, 16), block);
+                memcpy(expected.byte_ptr() + 16 * i, block.byte_ptr(), 16);
+            }
+            cipher.encrypt_blocks(blocks.byte_ptr(), result.byte_ptr(), n_blocks);
+            ASSERT_TRUE(equal(result(0, 16 * n_blocks), expected(0, 16 * n_blocks)));
+
+            // in place
+            cipher.decrypt_blocks(result.byte_ptr(), result.byte_ptr(), n_blocks);
+            ASSERT_TRUE(equal(result(0, 16 * n_blocks), blocks(0, 16 * n_blocks)));
+        }
+    }
+}
+
+TEST(KuznyechikTest, BlockPrimitive) {
+    ByteBlock pt = hex_to_bytes("1122334455667700ffeeddccbbaa9988");
+    bool was_enabled = ByteStats::enabled();
+    ByteStats::set_enabled(true);
+
+    for(auto engine : ENGINES) {
+        Kuznyechik cipher(hex_to_bytes(KEY), engine);
+        uint8_t ct[16], result[16];
+
+        ByteStats::reset();
+        cipher.encrypt_block(pt.byte_ptr(), ct);
+        cipher.decrypt_block(ct, result);
+        ASSERT_EQ(ByteStats::this_thread().allocations, 0);
+        ASSERT_EQ(hex_representation(ByteView(ct, 16)), "7f679d90bebc24305a468d42b9d4edcd");
+        ASSERT_TRUE(equal(ByteView(result, 16), pt));
+
+        // in place
+        cipher.encrypt_block(result, result);
+        ASSERT_TRUE(equal(ByteView(result, 16), ByteView(ct, 16)));
+        cipher.decrypt_block(result, result);
+        ASSERT_TRUE(equal(ByteView(result, 16), pt));
+    }
+    ByteStats::set_enabled(was_enabled);
+}
+
+TEST(KuznyechikTest, Rekey) {
+    ByteBlock other_key(32), pt = hex_to_bytes("1122334455667700ffeeddccbbaa9988");
+    for(size_t i = 0; i < other_key.size(); i++) other_key[i] = 3 * i + 1;
+    bool was_enabled = ByteStats::enabled();
+    ByteStats::set_enabled(true);
+
+    for(auto engine : ENGINES) {
+        Kuznyechik cipher(other_key, engine), fresh(other_key, engine);
+        ByteBlock key = hex_to_bytes(KEY), ct, expected;
+
+        ByteStats::reset();
+        cipher.rekey(key.byte_ptr());
+        ASSERT_EQ(ByteStats::this_thread().allocations, 0);
+        cipher.encrypt(pt, ct);
+        ASSERT_EQ(hex_representation(ct), "7f679d90bebc24305a468d42b9d4edcd");
+
+        cipher.rekey(other_key.byte_ptr());
+        cipher.encrypt(pt, ct);
+        fresh.encrypt(pt, expected);
+        ASSERT_TRUE(equal(ct, expected));
+    }
+    ByteStats::set_enabled(was_enabled);
+}
+
+TEST(KuznyechikTest, DefaultEngine) {
+    ASSERT_EQ(Kuznyechik::default_engine(), Kuznyechik::best_engine());
+    Kuznyechik::set_default_engine(Kuznyechik::Engine::compact);
+    ASSERT_EQ(Kuznyechik::default_engine(), Kuznyechik::Engine::compact);
+
+    Kuznyechik cipher(hex_to_bytes(KEY));
+    ByteBlock ct;
+    cipher.encrypt(hex_to_bytes("1122334455667700ffeeddccbbaa9988"), ct);
+    ASSERT_EQ(hex_representation(ct), "7f679d90bebc24305a468d42b9d4edcd");
+    Kuznyechik::set_default_engine(Kuznyechik::best_engine());
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <MyCryptoLib/mycrypto.hpp>
 #include <MyCryptoLib/kw.hpp>
+#include <MyCryptoLib/bytepool.hpp>
 
 class KWTest : public testing::Test {
 public:
@@ -117,3 +118,41 @@ TEST_F(KWPTest, FromFile) {
 
     SUCCEED();
 }
+
+// Every buffer the pool hands out until it runs dry is zeroed
+static bool pool_is_clean(size_t size) {
+    std::vector<BYTE *> bodies;
+    bool clean = true;
+    BytePool::reset_statistics();
+    while(!BytePool::statistics().misses) {
+        BYTE * body = BytePool::acquire(size);
+        bodies.push_back(body);
+        if(BytePool::statistics().misses) break;
+        for(size_t i = 0; i < size; i++) if(body[i]) clean = false;
+    }
+    for(auto body : bodies) BytePool::recycle(body, size);
+    return clean;
+}
+
+TEST(KeyUnwrapTest, NonsensitiveOutputLeavesNothing) {
+    ByteBlock kek(32), key(64), wrapped, result;
+    for(size_t i = 0; i < kek.size(); i++) kek[i] = 7 * i + 1;
+    for(size_t i = 0; i < key.size(); i++) key[i] = 0x80 | i;
+    BytePool::set_enabled(true);
+
+    KeyWrapFunction(wrapped, key, kek);
+    BytePool::trim();
+    result.set_sensitivity(Sensitivity::nonsensitive);
+    KeyUnwrapFunction(result, wrapped, kek);
+    ASSERT_TRUE(equal(result, key));
+    ASSERT_EQ(result.sensitivity(), Sensitivity::sensitive);
+    ASSERT_TRUE(pool_is_clean(wrapped.size()));
+
+    KeyWrapPaddedFunction(wrapped, key, kek);
+    BytePool::trim();
+    result = ByteBlock();
+    result.set_sensitivity(Sensitivity::nonsensitive);
+    KeyUnwrapPaddedFunction(result, wrapped, kek);
+    ASSERT_TRUE(equal(result, key));
+    ASSERT_TRUE(pool_is_clean(wrapped.size()));
+}
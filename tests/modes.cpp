@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <MyCryptoLib/mycrypto.hpp>
+#include <MyCryptoLib/Kuznyechik.hpp>
+#include <MyCryptoLib/Rijndael.hpp>
+
+static const char * KEY =
+    "8899aabbccddeeff0011223344556677fedcba98765432100123456789abcdef";
+static const char * IV = "1234567890abcef0a1b2c3d4e5f00112";
+static const char * PLAINTEXT =
+    "1122334455667700ffeeddccbbaa998800112233445566778899aabbcceeff0a"
+    "112233445566778899aabbcceeff0a002233445566778899aabbcceeff0a0011"
+    "aabbcc";
+
+// GOST R 34.13-2015, A.2.1
+TEST(ModesTest, KuznyechikECB) {
+    ECB_Mode<Kuznyechik> ecb(Kuznyechik(hex_to_bytes(KEY)));
+    ByteBlock pt = hex_to_bytes(PLAINTEXT), ct, result;
+
+    ecb.encrypt(pt(0, 64), ct);
+    ASSERT_EQ(hex_representation(ct),
+        "7f679d90bebc24305a468d42b9d4edcdb429912c6e0032f9285452d76718d08b"
+        "f0ca33549d247ceef3f5a5313bd4b157d0b09ccde830b9eb3a02c4c5aa8ada98");
+
+    ecb.decrypt(ct, result);
+    ASSERT_TRUE(equal(result, pt(0, 64)));
+
+    ASSERT_THROW(ecb.encrypt(pt, ct), std::invalid_argument);
+}
+
+TEST(ModesTest, KuznyechikCFB) {
+    CFB_Mode<Kuznyechik> cfb(Kuznyechik(hex_to_bytes(KEY)), hex_to_bytes(IV));
+    ByteBlock pt = hex_to_bytes(PLAINTEXT), ct, result;
+    const char * expected =
+        "81800a59b1842b24ff1f795e897abd9568c1b99c4df59cc7951e3739b5b3cdbf"
+        "073f4dd2d6deb3cfb026545f7af1d8e8e1c852e9a8567162dbb5da7f66dea926"
+        "dd9564";
+
+    cfb.encrypt(pt, ct);
+    ASSERT_EQ(hex_representation(ct), expected);
+
+    cfb.decrypt(ct, result);
+    ASSERT_TRUE(equal(result, pt));
+    cfb.parallel_decrypt(ct, result);
+    ASSERT_TRUE(equal(result, pt));
+
+    ByteBlock block = pt.deep_copy();
+    cfb.encrypt(block, block);
+    ASSERT_EQ(hex_representation(block), expected);
+    cfb.parallel_decrypt(block, block);
+    ASSERT_TRUE(equal(block, pt));
+}
+
+TEST(ModesTest, KuznyechikOFB) {
+    OFB_Mode<Kuznyechik> ofb(Kuznyechik(hex_to_bytes(KEY)), hex_to_bytes(IV));
+    ByteBlock pt = hex_to_bytes(PLAINTEXT), ct, result;
+
+    ofb.encrypt(pt, ct);
+    ASSERT_EQ(hex_representation(ct),
+        "81800a59b1842b24ff1f795e897abd95779146db2d93a94ed93cf68b32397f19"
+        "e93c9e57441d870545f24036a58ceea3cf3f0061d56423545b960d864cc868da"
+        "0b2fc5");
+
+    ofb.decrypt(ct, ct);
+    ASSERT_TRUE(equal(ct, pt));
+}
+
+// FIPS 197, C.1 repeated, runs through grouped and single blocks
+TEST(ModesTest, AES128ECB) {
+    ECB_Mode<AES128> ecb(AES128(hex_to_bytes("000102030405060708090a0b0c0d0e0f")));
+    std::string pt_hex, ct_hex;
+    for(int i = 0; i < 6; i++) {
+        pt_hex += "00112233445566778899aabbccddeeff";
+        ct_hex += "69c4e0d86a7b0430d8cdb78070b4c55a";
+    }
+    ByteBlock pt = hex_to_bytes(pt_hex), ct;
+
+    ecb.encrypt(pt, ct);
+    ASSERT_EQ(hex_representation(ct), ct_hex);
+    ecb.decrypt(ct, ct);
+    ASSERT_TRUE(equal(ct, pt));
+}
+
+TEST(ModesTest, LongMessageInPlace) {
+    ByteBlock key = hex_to_bytes(KEY);
+    CFB_Mode<AES128> cfb(AES128(key(0, 16)), hex_to_bytes(IV));
+    ByteBlock pt(100000), ct, result;
+    for(size_t i = 0; i < pt.size(); i++) pt[i] = i * 31;
+
+    cfb.encrypt(hex_to_bytes(PLAINTEXT), ct);
+    ASSERT_EQ(hex_representation(ct),
+        "1d9f97798fd7c829c1eabc3a69f9304706413f9445f2f50e42a9bfc911a187dc"
+        "f56d9419300174aec2f39c5b5a07cf752ab66471d58e07a9fe0cb7afcb2cc9be"
+        "1ab0d1");
+
+    cfb.encrypt(pt, ct);
+
+    result = ct.deep_copy();
+    const BYTE * body = result.byte_ptr();
+    cfb.parallel_decrypt(result, result);
+    ASSERT_EQ(result.byte_ptr(), body);
+    ASSERT_TRUE(equal(result, pt));
+
+    BYTE * raw = new BYTE [pt.size()];
+    cfb.decrypt(ct, raw);
+    ASSERT_TRUE(equal(ByteView(raw, pt.size()), pt));
+    delete [] raw;
+}
+
+// Cut bb into pieces of given lengths, the last one takes the rest
+template <typename View, typename Block>
+static std::vector<View> cut(Block & bb, std::vector<size_t> lengths) {
+    std::vector<View> segments;
+    size_t pos = 0;
+    for(size_t length : lengths) {
+        segments.push_back(View(bb.byte_ptr() + pos, length));
+        pos += length;
+    }
+    segments.push_back(View(bb.byte_ptr() + pos, bb.size() - pos));
+    return segments;
+}
+
+TEST(ModesTest, ScatterGather) {
+    CFB_Mode<Kuznyechik> cfb(Kuznyechik(hex_to_bytes(KEY)), hex_to_bytes(IV));
+    OFB_Mode<Kuznyechik> ofb(Kuznyechik(hex_to_bytes(KEY)), hex_to_bytes(IV));
+    ByteBlock pt = hex_to_bytes(PLAINTEXT), expected, ct(pt.size()), result(pt.size());
+
+    auto src = cut<ByteView>(pt, {0, 5, 16, 27, 0, 1});
+    auto dst = cut<MutableByteView>(ct, {40, 3});
+
+    cfb.encrypt(pt, expected);
+    SegmentReader cfb_in(src);
+    SegmentWriter cfb_out(dst);
+    cfb.encrypt(cfb_in, cfb_out);
+    ASSERT_TRUE(equal(ct, expected));
+    ASSERT_EQ(cfb_in.remaining(), 0);
+    ASSERT_EQ(cfb_out.remaining(), 0);
+
+    // in place, over the same chain of segments
+    auto chain = cut<MutableByteView>(ct, {7, 16, 16, 1});
+    auto chain_in = cut<ByteView>(ct, {7, 16, 16, 1});
+    SegmentReader in_place_in(chain_in);
+    SegmentWriter in_place_out(chain);
+    cfb.decrypt(in_place_in, in_place_out);
+    ASSERT_TRUE(equal(ct, pt));
+
+    ofb.encrypt(pt, expected);
+    auto ofb_dst = cut<MutableByteView>(result, {17, 17, 17});
+    SegmentReader ofb_in(src);
+    SegmentWriter ofb_out(ofb_dst);
+    ofb.encrypt(ofb_in, ofb_out);
+    ASSERT_TRUE(equal(result, expected));
+
+    SegmentReader too_long(src);
+    SegmentWriter too_short(ofb_dst.data(), 2);
+    ASSERT_THROW(cfb.encrypt(too_long, too_short), std::length_error);
+}
@@ -124,3 +124,18 @@ TEST_F(SHA256Test, Sha256LongMsg){
     }
     SUCCEED();
 }
+
+TEST_F(SHA256Test, ScatteredMsg) {
+    SHA256 algorithm;
+    ByteBlock msg(300), expected, result;
+    for (size_t i = 0; i < msg.size(); i++) msg[i] = i * 7;
+    algorithm.hash(msg, expected);
+
+    std::vector<ByteView> segments = {
+        msg(0, 1), msg(1, 0), msg(1, 100), msg(101, 64), msg(165, 135)
+    };
+    SegmentReader src(segments);
+    algorithm.hash(src, result);
+    ASSERT_TRUE(equal(result, expected));
+    ASSERT_EQ(src.remaining(), 0);
+}
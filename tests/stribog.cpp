@@ -138,3 +138,18 @@ TEST_F(Stribog512Test, ZeroMsg) {
     }
     SUCCEED();
 }
+
+TEST_F(Stribog512Test, ScatteredMsg) {
+    Stribog512 alg;
+    ByteBlock msg(300), expected, result;
+    for (size_t i = 0; i < msg.size(); i++) msg[i] = i * 7;
+    alg.hash(msg, expected);
+
+    std::vector<ByteView> segments = {
+        msg(0, 50), msg(50, 0), msg(50, 100), msg(150, 64), msg(214, 86)
+    };
+    SegmentReader src(segments);
+    alg.hash(src, result);
+    ASSERT_TRUE(equal(result, expected));
+    ASSERT_EQ(src.remaining(), 0);
+}